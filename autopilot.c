@@ -0,0 +1,120 @@
+/*
+ * autopilot.c
+ *
+ * Autopilot - see autopilot.h
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <avr/pgmspace.h>
+
+#include "autopilot.h"
+#include "game.h"
+#include "terminalio.h"
+
+static uint8_t mode = AUTOPILOT_OFF;
+static uint32_t nextDecisionTime;
+static AutopilotStats stats;
+
+void autopilot_set_mode(uint8_t newMode) {
+	mode = newMode;
+	// Make the first decision straight away
+	nextDecisionTime = 0;
+}
+
+uint8_t autopilot_mode(void) {
+	return mode;
+}
+
+void autopilot_start_game(void) {
+	nextDecisionTime = 0;
+}
+
+// Work out which column to shoot at next. Returns -1 if there's nothing
+// worth shooting at.
+static int8_t choose_target(void) {
+	int8_t base = get_base_position();
+	int8_t target = -1;
+	int8_t targetY = FIELD_HEIGHT;
+	uint8_t targetDistance = FIELD_WIDTH;
+	int8_t y;
+	uint8_t distance;
+
+	for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
+		y = lowest_asteroid(x);
+		// Asteroids below row 2 can't be hit (projectiles start in row 2)
+		// and there's no point firing twice at the same one
+		if(y < 2 || projectiles_in_column(x)) {
+			continue;
+		}
+		distance = (x > base) ? x - base : base - x;
+		if(y < targetY || (y == targetY && distance < targetDistance)) {
+			target = x;
+			targetY = y;
+			targetDistance = distance;
+		}
+	}
+	return target;
+}
+
+int8_t autopilot_next_input(uint32_t now) {
+	int8_t target;
+	int8_t base;
+
+	if(now < nextDecisionTime) {
+		return INPUT_NONE;
+	}
+	nextDecisionTime = now + AUTOPILOT_PERIOD;
+
+	target = choose_target();
+	if(target == -1) {
+		return INPUT_NONE;
+	}
+	base = get_base_position();
+	if(target < base) {
+		return INPUT_LEFT;
+	} else if(target > base) {
+		return INPUT_RIGHT;
+	} else if(can_fire()) {
+		return INPUT_FIRE;
+	}
+	return INPUT_NONE;
+}
+
+uint32_t autopilot_next_time(void) {
+	return nextDecisionTime;
+}
+
+void autopilot_game_over(uint32_t score, uint32_t gameTime) {
+	stats.games++;
+	stats.totalScore += score;
+	stats.totalTime += gameTime;
+	if(score > stats.bestScore) {
+		stats.bestScore = score;
+	}
+	if(gameTime > stats.longestGame) {
+		stats.longestGame = gameTime;
+	}
+}
+
+const AutopilotStats* autopilot_stats(void) {
+	return &stats;
+}
+
+void autopilot_print_stats(void) {
+	if(stats.games == 0) {
+		return;
+	}
+	// (Kept short so it doesn't run into the playing field)
+	move_cursor(10,11);
+	printf_P(PSTR("Autopilot: %u games"), stats.games);
+	move_cursor(10,12);
+	printf_P(PSTR("Best score %lu, average %lu"),
+			(unsigned long)stats.bestScore, 
+			(unsigned long)(stats.totalScore / stats.games));
+	move_cursor(10,13);
+	printf_P(PSTR("Longest %lu s, %lu s played"),
+			(unsigned long)(stats.longestGame / 1000),
+			(unsigned long)(stats.totalTime / 1000));
+}
@@ -0,0 +1,78 @@
+/*
+ * autopilot.h
+ *
+ * Autopilot - plays the game by itself, for soak testing and to push the
+ * game into the states (high scores, fastest asteroids, most output)
+ * that are hard to reach by hand. It looks at the game state (see
+ * get_base_position() etc. in game.h) and decides on an input - move
+ * left, move right or fire - which play_game() then deals with exactly
+ * as if it came from a button. So the autopilot's games are recorded
+ * and can be replayed like any other (see replay.h).
+ *
+ * Strategy: the target is the column with the lowest asteroid that
+ * doesn't already have a projectile on its way up (the nearest column
+ * if there's a tie). The base moves towards the target and fires once
+ * it's underneath. At most one decision is made every AUTOPILOT_PERIOD
+ * milliseconds of game time - about as fast as a (quick) person can
+ * press buttons. The decisions only depend on the game state and the
+ * game time, so a game played by the autopilot is the same every time
+ * for the same seed.
+ *
+ * Modes:
+ *   AUTOPILOT_OFF       - the game is played by hand (the default)
+ *   AUTOPILOT_REAL_TIME - the game runs at its normal speed
+ *   AUTOPILOT_MAX_SPEED - play_game() doesn't wait for time to pass but
+ *                         jumps straight to the next move or decision
+ *                         (as it does when replaying), so games run as
+ *                         fast as the output can be sent
+ * When the autopilot is on, a new game is started automatically after
+ * each game over (after AUTOPILOT_RESTART_DELAY milliseconds in real
+ * time mode, straight away at maximum speed).
+ */
+
+#ifndef AUTOPILOT_H_
+#define AUTOPILOT_H_
+
+#include <stdint.h>
+
+#define AUTOPILOT_OFF		0
+#define AUTOPILOT_REAL_TIME	1
+#define AUTOPILOT_MAX_SPEED	2
+
+#define AUTOPILOT_PERIOD		100
+#define AUTOPILOT_RESTART_DELAY	2000
+
+void autopilot_set_mode(uint8_t mode);
+uint8_t autopilot_mode(void);
+
+// Must be called at the start of each game the autopilot is to play
+// (game time 0)
+void autopilot_start_game(void);
+
+// Decide what to do at the given game time. Returns an INPUT_... value
+// (see game.h) - INPUT_NONE if there's nothing to do or it's not yet
+// time for the next decision.
+int8_t autopilot_next_input(uint32_t now);
+
+// Game time of the autopilot's next decision
+uint32_t autopilot_next_time(void);
+
+// Totals over all the games the autopilot has played (since reset).
+// Times are game times in milliseconds.
+typedef struct {
+	uint16_t games;
+	uint32_t bestScore;
+	uint32_t totalScore;
+	uint32_t longestGame;
+	uint32_t totalTime;
+} AutopilotStats;
+
+// Add a finished game to the totals
+void autopilot_game_over(uint32_t score, uint32_t gameTime);
+
+const AutopilotStats* autopilot_stats(void);
+
+// Show the totals on the terminal
+void autopilot_print_stats(void);
+
+#endif /* AUTOPILOT_H_ */
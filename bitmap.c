@@ -0,0 +1,32 @@
+/*
+ * bitmap.c
+ *
+ * Program memory bitmaps for the LED matrix - see bitmap.h
+ */
+
+#include <avr/pgmspace.h>
+
+#include "bitmap.h"
+#include "ledmatrix.h"
+
+void bitmap_draw(MatrixData data, const uint8_t* bitmap, PixelColour colour) {
+	uint8_t column_bits;
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		column_bits = pgm_read_byte(&bitmap[x]);
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			if(column_bits & 1) {
+				data[x][y] = colour;
+			}
+			column_bits >>= 1;
+		}
+	}
+}
+
+void bitmap_show(const uint8_t* bitmap, PixelColour colour) {
+	MatrixData data;
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		set_matrix_column_to_colour(data[x], COLOUR_BLACK);
+	}
+	bitmap_draw(data, bitmap, colour);
+	ledmatrix_update_all(data);
+}
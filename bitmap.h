@@ -0,0 +1,28 @@
+/*
+ * bitmap.h
+ *
+ * Single colour bitmaps for the LED matrix, stored in program memory.
+ * A bitmap is one byte per LED matrix column (MATRIX_NUM_COLUMNS bytes,
+ * column 0 first). Bit y of a column byte is set if the pixel in row y
+ * is lit. e.g.
+ *     static const uint8_t smiley[MATRIX_NUM_COLUMNS] PROGMEM = { ... };
+ *     bitmap_show(smiley, COLOUR_GREEN);
+ */
+
+#ifndef BITMAP_H_
+#define BITMAP_H_
+
+#include <stdint.h>
+#include "ledmatrix.h"
+
+// Draw the (program memory) bitmap into the given display data using the
+// given colour. Pixels which aren't lit in the bitmap are left unchanged
+// so several bitmaps can be drawn on top of each other.
+void bitmap_draw(MatrixData data, const uint8_t* bitmap, PixelColour colour);
+
+// Show the (program memory) bitmap on the LED matrix in the given colour
+// (all other pixels are turned off). This takes a single 
+// ledmatrix_update_all() rather than one update per pixel.
+void bitmap_show(const uint8_t* bitmap, PixelColour colour);
+
+#endif /* BITMAP_H_ */
@@ -7,6 +7,7 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include "buttons.h"
+#include "isrstats.h"
 
 // Global variable to keep track of the last button state so that we 
 // can detect changes when an interrupt fires. The lower 4 bits (0 to 3)
@@ -55,11 +56,13 @@ int8_t button_pushed(void) {
 		// Save whether interrupts were enabled and turn them off
 		int8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
 		cli();
+		ISR_STATS_BEGIN();
 		
 		for(uint8_t i = 1; i < queue_length; i++) {
 			button_queue[i-1] = button_queue[i];
 		}
 		queue_length--;
+		ISR_STATS_END(CS_BUTTON_PUSHED);
 		
 		if(interrupts_were_enabled) {
 			// Turn them back on again
@@ -71,6 +74,8 @@ int8_t button_pushed(void) {
 
 // Interrupt handler for a change on buttons
 ISR(PCINT1_vect) {
+	ISR_STATS_BEGIN();
+
 	// Get the current state of the buttons. We'll compare this with
 	// the last state to see what has changed.
 	uint8_t button_state = PINB & 0x0F;
@@ -92,4 +97,5 @@ ISR(PCINT1_vect) {
 	
 	// Remember this button state
 	last_button_state = button_state;
+	ISR_STATS_END(CS_ISR_PCINT1);
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+/*
+ * compositor.c
+ *
+ * LED matrix layers - see compositor.h
+ *
+ * Each layer is stored as one byte per LED matrix column with bit y set
+ * if the layer occupies row y (the same layout as bitmap.h). Cells that
+ * may have changed since the last flush are marked in the same way in 
+ * dirty[]. shown is what we last sent to the LED matrix, so that a
+ * cell which changes and then changes back isn't sent at all. It's kept
+ * packed (see PackedMatrixData in ledmatrix.h) to save RAM. Changed 
+ * cells are sent as render commands (see render.h).
+ */
+
+#include <stdint.h>
+
+#include "compositor.h"
+#include "ledmatrix.h"
+#include "effects.h"
+#include "render.h"
+
+static uint8_t layers[NUM_LAYERS][MATRIX_NUM_COLUMNS];
+static PixelColour layer_colours[NUM_LAYERS];
+static uint8_t dirty[MATRIX_NUM_COLUMNS];
+static PackedMatrixData shown;
+
+// Cells whose colour couldn't be kept in shown (because its palette was
+// full) - these are always sent when they're dirty
+static uint8_t unknown[MATRIX_NUM_COLUMNS];
+
+void compositor_init(void) {
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		for(uint8_t layer = 0; layer < NUM_LAYERS; layer++) {
+			layers[layer][x] = 0;
+		}
+		dirty[x] = 0;
+		unknown[x] = 0;
+	}
+	packed_matrix_clear(&shown);
+}
+
+void compositor_set(uint8_t layer, uint8_t x, uint8_t y) {
+	if(x < MATRIX_NUM_COLUMNS && y < MATRIX_NUM_ROWS) {
+		layers[layer][x] |= (1 << y);
+		dirty[x] |= (1 << y);
+	}
+}
+
+void compositor_clear(uint8_t layer, uint8_t x, uint8_t y) {
+	if(x < MATRIX_NUM_COLUMNS && y < MATRIX_NUM_ROWS) {
+		layers[layer][x] &= ~(1 << y);
+		dirty[x] |= (1 << y);
+	}
+}
+
+void compositor_clear_layer(uint8_t layer) {
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		dirty[x] |= layers[layer][x];
+		layers[layer][x] = 0;
+	}
+}
+
+void compositor_set_layer_colour(uint8_t layer, PixelColour colour) {
+	if(layer_colours[layer] == colour) {
+		return;
+	}
+	layer_colours[layer] = colour;
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		dirty[x] |= layers[layer][x];
+	}
+}
+
+// Work out the final colour of a cell from the layers
+static PixelColour cell_colour(uint8_t x, uint8_t y) {
+	uint8_t mask = (1 << y);
+	PixelColour colour = COLOUR_BLACK;
+	
+	// Find the highest priority single colour layer
+	for(int8_t layer = LAYER_EFFECT - 1; layer >= 0; layer--) {
+		if(layers[layer][x] & mask) {
+			colour = layer_colours[layer];
+			break;
+		}
+	}
+	if(layers[LAYER_EFFECT][x] & mask) {
+		colour = effects_colour(EFFECT_TARGET_CELL(x, y), colour);
+	}
+	return colour;
+}
+
+uint8_t compositor_flush(void) {
+	uint8_t cells_sent = 0;
+	uint8_t column_dirty;
+	PixelColour colour;
+	
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		column_dirty = dirty[x];
+		if(!column_dirty) {
+			continue;
+		}
+		dirty[x] = 0;
+		for(uint8_t y = 0; column_dirty; y++, column_dirty >>= 1) {
+			if(!(column_dirty & 1)) {
+				continue;
+			}
+			colour = cell_colour(x, y);
+			if(colour != packed_matrix_get(&shown, x, y) || 
+					(unknown[x] & (1 << y))) {
+				if(packed_matrix_set(&shown, x, y, colour)) {
+					unknown[x] &= ~(1 << y);
+				} else {
+					unknown[x] |= (1 << y);
+				}
+				render_cell(x, y, colour);
+				cells_sent++;
+			}
+		}
+	}
+	return cells_sent;
+}
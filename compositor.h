@@ -0,0 +1,55 @@
+/*
+ * compositor.h
+ *
+ * Builds the LED matrix display out of layers. Each layer records which 
+ * LED matrix cells it occupies (e.g. the cells that have an asteroid in
+ * them). Where layers overlap, the cell shows the highest priority 
+ * layer, so removing something from one layer never blanks out another
+ * layer underneath it.
+ *
+ * Changes to the layers are only sent to the LED matrix when 
+ * compositor_flush() is called, and then only for cells whose final
+ * colour has actually changed - so each cell is sent at most once per
+ * flush no matter how many times it was changed in between.
+ *
+ * Cell coordinates are LED matrix x (0 to 15) and y (0 to 7) as for
+ * ledmatrix_update_pixel().
+ */
+
+#ifndef COMPOSITOR_H_
+#define COMPOSITOR_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+// Layers, lowest priority first. Each layer is drawn in a single colour
+// (see compositor_set_layer_colour()) except for LAYER_EFFECT - cells in
+// that layer take their colour from the effects module (see effects.h,
+// the effect target is EFFECT_TARGET_CELL(x,y)), with the colour of the
+// layers underneath being the cell's own colour.
+#define LAYER_BASE			0
+#define LAYER_ASTEROID		1
+#define LAYER_PROJECTILE	2
+#define LAYER_EFFECT		3
+#define NUM_LAYERS			4
+
+// Empty all of the layers. The LED matrix is assumed to be clear (e.g.
+// ledmatrix_clear() has just been called).
+void compositor_init(void);
+
+// Add a cell to, or remove a cell from, a layer
+void compositor_set(uint8_t layer, uint8_t x, uint8_t y);
+void compositor_clear(uint8_t layer, uint8_t x, uint8_t y);
+
+// Remove all cells from a layer
+void compositor_clear_layer(uint8_t layer);
+
+// Set the colour a layer is drawn in
+void compositor_set_layer_colour(uint8_t layer, PixelColour colour);
+
+// Send the cells whose colour has changed since the last flush to the
+// LED matrix (as RENDER_CELL commands - see render.h). Returns the 
+// number of cells sent.
+uint8_t compositor_flush(void);
+
+#endif /* COMPOSITOR_H_ */
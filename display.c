@@ -0,0 +1,324 @@
+/*
+ * display.c
+ *
+ * Display backends - see display.h
+ */
+
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+#include "display.h"
+#include "ledmatrix.h"
+#include "terminalio.h"
+#include "tickstats.h"
+
+static const DisplayBackend* backends[MAX_DISPLAY_BACKENDS];
+static uint8_t numBackends = 0;
+
+uint8_t display_add_backend(const DisplayBackend* backend) {
+	if(numBackends == MAX_DISPLAY_BACKENDS) {
+		return 0;
+	}
+	backends[numBackends++] = backend;
+	return 1;
+}
+
+void display_remove_backends(void) {
+	numBackends = 0;
+}
+
+void display_render_command(const RenderCommand* command) {
+	const DisplayBackend* backend;
+	
+	for(uint8_t i = 0; i < numBackends; i++) {
+		TICK_STATS_BEGIN();
+		backend = backends[i];
+		switch(command->type) {
+			case RENDER_CELL:
+				if(backend->cell) {
+					backend->cell(command->cell.x, command->cell.y, 
+							command->cell.colour);
+				}
+				break;
+			case RENDER_SCORE:
+				if(backend->score) {
+					backend->score(command->value);
+				}
+				break;
+			case RENDER_LIVES:
+				if(backend->lives) {
+					backend->lives(command->value);
+				}
+				break;
+			case RENDER_MESSAGE:
+				if(backend->message) {
+					backend->message(command->message);
+				}
+				break;
+			case RENDER_CLEAR:
+				if(backend->clear) {
+					backend->clear();
+				}
+				break;
+			case RENDER_END_FRAME:
+				if(backend->end_frame) {
+					backend->end_frame();
+				}
+				break;
+		}
+		TICK_STATS_END(backend == &led_matrix_backend ? 
+				TICK_PHASE_LED_FLUSH : TICK_PHASE_HUD);
+	}
+}
+
+/******** LED MATRIX ****************/
+
+const DisplayBackend led_matrix_backend = {
+	.cell = ledmatrix_update_pixel,
+	.clear = ledmatrix_clear,
+};
+
+/******** TERMINAL ****************/
+
+// Messages are shown on the terminal in this many columns
+#define MESSAGE_WIDTH 32
+
+// Columns of the box around the playing field
+#define BOX_LEFT	(TERMINAL_FIELD_LEFT - 1)
+#define BOX_RIGHT	(TERMINAL_FIELD_LEFT + 2 * MATRIX_NUM_ROWS)
+
+// Scrolling the field costs about as much output as redrawing this many
+// cells (moving the cursor, the scroll itself and redrawing the sides of
+// the box on the new top row), so we only scroll if it saves more than
+// this.
+#define SCROLL_COST 2
+
+// Playing field cell colours on the terminal. The LED colours are
+// reduced to the few background colours a terminal has.
+#define CELL_BLACK	0
+#define CELL_RED	1
+#define CELL_GREEN	2
+#define CELL_YELLOW	3
+
+static const uint8_t cell_attributes[] PROGMEM = {
+		TERM_RESET, BG_RED, BG_GREEN, BG_YELLOW };
+
+// How the playing field should look (field) and how it looks on the 
+// terminal now (shown), indexed by LED matrix x. There are only four
+// cell colours so each column is packed into 16 bits - bits 2y and 2y+1
+// are the colour of row y. Cells are only drawn at the end of a frame,
+// once we know everything that has changed - when the asteroids have all
+// moved down one row, scrolling the field and drawing the few cells that
+// are then different (e.g. the base and new asteroids) is much cheaper
+// than redrawing every cell.
+static uint16_t field[MATRIX_NUM_COLUMNS];
+static uint16_t shown[MATRIX_NUM_COLUMNS];
+static uint8_t fieldChanged;
+static uint8_t fieldOff;
+
+#define CELL_SHIFT(y)			(2 * (y))
+#define GET_CELL(column, y)		(((column) >> CELL_SHIFT(y)) & 0x03)
+
+static uint8_t cell_colour(PixelColour colour) {
+	uint8_t green = colour >> 4;
+	uint8_t red = colour & 0x0F;
+	
+	if(colour == COLOUR_BLACK) {
+		return CELL_BLACK;
+	} else if(green > 2 * red) {
+		return CELL_GREEN;
+	} else if(red > 2 * green) {
+		return CELL_RED;
+	} else {
+		return CELL_YELLOW;
+	}
+}
+
+static void terminal_cell(uint8_t x, uint8_t y, PixelColour colour) {
+	field[x] = (field[x] & ~(0x03 << CELL_SHIFT(y))) | 
+			((uint16_t)cell_colour(colour) << CELL_SHIFT(y));
+	fieldChanged = 1;
+}
+
+// Draw the sides of the box on the given row
+static void draw_box_sides(uint8_t row) {
+	move_cursor(BOX_LEFT, row);
+	putchar('#');
+	move_cursor(BOX_RIGHT, row);
+	putchar('#');
+}
+
+static void draw_box_edge(uint8_t row) {
+	move_cursor(BOX_LEFT, row);
+	for(uint8_t i = BOX_LEFT; i <= BOX_RIGHT; i++) {
+		putchar('#');
+	}
+}
+
+static void terminal_clear(void) {
+	// (CELL_BLACK is 0)
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		field[x] = 0;
+		shown[x] = 0;
+	}
+	fieldChanged = 0;
+	
+	normal_display_mode();
+	hide_cursor();
+	draw_box_edge(TERMINAL_FIELD_TOP - 1);
+	draw_box_edge(TERMINAL_FIELD_BOTTOM + 1);
+	for(uint8_t row = TERMINAL_FIELD_TOP; row <= TERMINAL_FIELD_BOTTOM; row++) {
+		// Clear the inside of the box as well
+		move_cursor(BOX_LEFT, row);
+		putchar('#');
+		for(uint8_t i = 0; i < 2 * MATRIX_NUM_ROWS; i++) {
+			putchar(' ');
+		}
+		putchar('#');
+	}
+	set_scroll_region(TERMINAL_FIELD_TOP, TERMINAL_FIELD_BOTTOM);
+}
+
+// Return the number of cells that would need to be drawn if the field
+// was first scrolled down by the given number of rows (0 or 1)
+static uint8_t cells_to_draw(uint8_t scroll) {
+	uint8_t count = 0;
+	uint16_t differences;
+	
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		differences = field[x];
+		if(x + scroll < MATRIX_NUM_COLUMNS) {
+			differences ^= shown[x + scroll];
+		}
+		for(; differences; differences >>= 2) {
+			if(differences & 0x03) {
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+static void scroll_field_down(void) {
+	// The cursor must be on the top row of the scroll region
+	move_cursor(BOX_LEFT, TERMINAL_FIELD_TOP);
+	scroll_down();
+	draw_box_sides(TERMINAL_FIELD_TOP);
+	
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS - 1; x++) {
+		shown[x] = shown[x + 1];
+	}
+	shown[MATRIX_NUM_COLUMNS - 1] = 0;
+}
+
+static void terminal_end_frame(void) {
+	uint8_t row, column;
+	uint8_t cursorRow = 0, cursorColumn = 0;
+	uint8_t colour = CELL_BLACK;
+	uint8_t cell;
+	
+	if(!fieldChanged || fieldOff) {
+		return;
+	}
+	fieldChanged = 0;
+	
+	if(cells_to_draw(1) + SCROLL_COST < cells_to_draw(0)) {
+		scroll_field_down();
+	}
+	
+	// Draw the cells that differ, top to bottom and left to right. The
+	// cursor is only moved, and the colour only changed, when needed.
+	for(int8_t x = MATRIX_NUM_COLUMNS - 1; x >= 0; x--) {
+		row = TERMINAL_FIELD_TOP + (MATRIX_NUM_COLUMNS - 1 - x);
+		for(int8_t y = MATRIX_NUM_ROWS - 1; y >= 0; y--) {
+			cell = GET_CELL(field[x], y);
+			if(cell == GET_CELL(shown[x], y)) {
+				continue;
+			}
+			column = TERMINAL_FIELD_LEFT + 2 * (MATRIX_NUM_ROWS - 1 - y);
+			if(row != cursorRow || column != cursorColumn) {
+				move_cursor(column, row);
+			}
+			if(cell != colour) {
+				colour = cell;
+				set_display_attribute(pgm_read_byte(&cell_attributes[colour]));
+			}
+			putchar(' ');
+			putchar(' ');
+			cursorRow = row;
+			cursorColumn = column + 2;
+		}
+		shown[x] = field[x];
+	}
+	if(colour != CELL_BLACK) {
+		normal_display_mode();
+	}
+}
+
+static void terminal_score(uint16_t score) {
+	// Padded so that a shorter number covers a longer one
+	move_cursor(TERMINAL_SCORE_X, TERMINAL_SCORE_Y);
+	printf_P(PSTR("Score %-5u"), score);
+}
+
+static void terminal_lives(uint8_t lives) {
+	move_cursor(TERMINAL_SCORE_X, TERMINAL_LIVES_Y);
+	printf_P(PSTR("Lives Remaining %u"), lives);
+}
+
+static void terminal_message(const char* message) {
+	// Padded with spaces to cover any previous message (we don't
+	// clear to the end of the line as the playing field box is
+	// further along it)
+	move_cursor(TERMINAL_MESSAGE_X, TERMINAL_MESSAGE_Y);
+	fputs_P(message, stdout);
+	for(uint8_t i = strlen_P(message); i < MESSAGE_WIDTH; i++) {
+		putchar(' ');
+	}
+}
+
+void display_terminal_field(uint8_t on) {
+	fieldOff = !on;
+}
+
+const DisplayBackend terminal_backend = {
+	.cell = terminal_cell,
+	.score = terminal_score,
+	.lives = terminal_lives,
+	.message = terminal_message,
+	.clear = terminal_clear,
+	.end_frame = terminal_end_frame,
+};
+
+/******** NULL ****************/
+
+// The casts to void mark the arguments as unused
+static void null_cell(uint8_t x, uint8_t y, PixelColour colour) {
+	(void)x;
+	(void)y;
+	(void)colour;
+}
+
+static void null_value(uint16_t value) {
+	(void)value;
+}
+
+static void null_lives(uint8_t lives) {
+	(void)lives;
+}
+
+static void null_message(const char* message) {
+	(void)message;
+}
+
+static void null_void(void) {
+}
+
+const DisplayBackend null_backend = {
+	.cell = null_cell,
+	.score = null_value,
+	.lives = null_lives,
+	.message = null_message,
+	.clear = null_void,
+	.end_frame = null_void,
+};
@@ -0,0 +1,79 @@
+/*
+ * display.h
+ *
+ * Display backends. A backend is a table of functions which show the 
+ * game's output (see render.h) on some device. The game can drive any
+ * combination of backends at once - every render command is passed to
+ * each backend that has been added, in the order they were added. 
+ * A backend can leave an entry as 0 if it has nothing to show for that
+ * kind of command.
+ *
+ * Backends provided:
+ * led_matrix_backend - LED matrix cells
+ * terminal_backend   - a copy of the playing field, score, lives and 
+ *                      messages on the serial terminal
+ * null_backend       - does nothing (but is called for every command), so
+ *                      the game can be timed without any output cost
+ *                      ('n' chooses it instead of the other two for the
+ *                      next game - see project.c)
+ */
+
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+#include "ledmatrix.h"
+#include "render.h"
+
+typedef struct {
+	void (*cell)(uint8_t x, uint8_t y, PixelColour colour);
+	void (*score)(uint16_t score);
+	void (*lives)(uint8_t lives);
+	void (*message)(const char* message);
+	void (*clear)(void);
+	void (*end_frame)(void);
+} DisplayBackend;
+
+extern const DisplayBackend led_matrix_backend;
+extern const DisplayBackend terminal_backend;
+extern const DisplayBackend null_backend;
+
+#define MAX_DISPLAY_BACKENDS 3
+
+// Terminal layout (x is the column, y the row, as for move_cursor()).
+// The playing field is drawn in a box of '#' characters with each cell
+// two characters wide. LED matrix x (0 to 15) is shown from the bottom of
+// the box up, LED matrix y (0 to 7) from the right of the box to the
+// left, so the field looks the way it does on the LED matrix when the
+// game is played. The rows of the field are a scroll region, so anything
+// else on the terminal must be outside those rows.
+#define TERMINAL_FIELD_LEFT		48
+#define TERMINAL_FIELD_TOP		3
+#define TERMINAL_FIELD_BOTTOM	(TERMINAL_FIELD_TOP + MATRIX_NUM_COLUMNS - 1)
+#define TERMINAL_MESSAGE_X		10
+#define TERMINAL_MESSAGE_Y		2
+#define TERMINAL_SCORE_X		14
+#define TERMINAL_SCORE_Y		(TERMINAL_FIELD_BOTTOM + 3)
+#define TERMINAL_LIVES_Y		(TERMINAL_SCORE_Y + 1)
+#define TERMINAL_SEED_Y			(TERMINAL_SCORE_Y + 2)
+
+// Add a backend. Returns 1 if successful, 0 if there are already 
+// MAX_DISPLAY_BACKENDS backends.
+uint8_t display_add_backend(const DisplayBackend* backend);
+
+// Remove all backends (output is then thrown away)
+void display_remove_backends(void);
+
+// Pass a render command to all of the backends. This is the render
+// list consumer (see render_set_consumer()).
+void display_render_command(const RenderCommand* command);
+
+// Turn drawing the playing field on the terminal off (0) or on (1). The
+// terminal copy of the field is only for show, so it can be turned off 
+// if the board can't keep up (see highspeed.h). It's still kept up to 
+// date while it's off, and what has changed is drawn when it's turned
+// back on. (Score, lives and messages are still shown.)
+void display_terminal_field(uint8_t on);
+
+#endif /* DISPLAY_H_ */
@@ -0,0 +1,137 @@
+/*
+ * effects.c
+ *
+ * Timed visual effects - see effects.h
+ */
+
+#include <stdint.h>
+
+#include "effects.h"
+
+typedef struct {
+	uint8_t target;
+	uint8_t type;
+	PixelColour colour;
+	// What the effect currently looks like - for EFFECT_BLINK this is 0 
+	// when the effect colour is showing and 1 when it isn't, for 
+	// EFFECT_FADE it's the fade step. Always 0 for EFFECT_FLASH.
+	uint8_t phase;
+	uint16_t duration;
+	uint32_t startTime;
+} Effect;
+
+// Running effects, oldest first
+static Effect effects[MAX_EFFECTS];
+static uint8_t numEffects;
+
+static void (*redrawTarget)(uint8_t target);
+
+static void remove_effect(uint8_t effectNumber) {
+	for(uint8_t i = effectNumber; i < numEffects - 1; i++) {
+		effects[i] = effects[i + 1];
+	}
+	numEffects--;
+}
+
+// Work out the phase of an effect which has been running for the given
+// time
+static uint8_t effect_phase(Effect* effect, uint16_t elapsed) {
+	switch(effect->type) {
+		case EFFECT_BLINK:
+			return (elapsed / EFFECT_BLINK_PERIOD) & 1;
+		case EFFECT_FADE:
+			return ((uint32_t)elapsed * EFFECT_FADE_STEPS) / effect->duration;
+		default:
+			return 0;
+	}
+}
+
+void effects_init(void (*redraw)(uint8_t target)) {
+	redrawTarget = redraw;
+	numEffects = 0;
+}
+
+void effects_start(uint8_t target, uint8_t type, PixelColour colour, 
+		uint16_t duration, uint32_t now) {
+	Effect* effect;
+	
+	for(uint8_t i = 0; i < numEffects; i++) {
+		if(effects[i].target == target) {
+			remove_effect(i);
+			break;
+		}
+	}
+	if(numEffects == MAX_EFFECTS) {
+		// Replace the oldest effect - put its target back to normal
+		uint8_t oldTarget = effects[0].target;
+		remove_effect(0);
+		redrawTarget(oldTarget);
+	}
+	
+	effect = &effects[numEffects++];
+	effect->target = target;
+	effect->type = type;
+	effect->colour = colour;
+	effect->phase = 0;
+	effect->duration = duration;
+	effect->startTime = now;
+	redrawTarget(target);
+}
+
+void effects_update(uint32_t now) {
+	uint8_t i = 0;
+	uint32_t elapsed;
+	uint8_t phase;
+	uint8_t target;
+	
+	while(i < numEffects) {
+		elapsed = now - effects[i].startTime;
+		if(elapsed >= effects[i].duration) {
+			// Effect has finished - remove it and draw the target normally
+			target = effects[i].target;
+			remove_effect(i);
+			redrawTarget(target);
+			continue;
+		}
+		phase = effect_phase(&effects[i], elapsed);
+		if(phase != effects[i].phase) {
+			effects[i].phase = phase;
+			redrawTarget(effects[i].target);
+		}
+		i++;
+	}
+}
+
+uint8_t effects_active(uint8_t target) {
+	for(uint8_t i = 0; i < numEffects; i++) {
+		if(effects[i].target == target) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+PixelColour effects_colour(uint8_t target, PixelColour colour) {
+	Effect* effect;
+	uint8_t level;
+	
+	for(uint8_t i = 0; i < numEffects; i++) {
+		effect = &effects[i];
+		if(effect->target != target) {
+			continue;
+		}
+		switch(effect->type) {
+			case EFFECT_FLASH:
+				return effect->colour;
+			case EFFECT_BLINK:
+				return effect->phase ? colour : effect->colour;
+			case EFFECT_FADE:
+				// Scale the green (high 4 bits) and red (low 4 bits) 
+				// intensities down together
+				level = EFFECT_FADE_STEPS - effect->phase;
+				return ((((effect->colour >> 4) * level / EFFECT_FADE_STEPS) << 4) |
+						((effect->colour & 0x0F) * level / EFFECT_FADE_STEPS));
+		}
+	}
+	return colour;
+}
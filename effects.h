@@ -0,0 +1,77 @@
+/*
+ * effects.h
+ *
+ * Timed visual effects on the LED matrix - the game flashes the base when
+ * it's hit by an asteroid (EFFECT_FLASH), fades the asteroid out where
+ * it was (EFFECT_FADE) and blinks the cell where an asteroid is shot 
+ * (EFFECT_BLINK). An effect changes the colour something is drawn in for
+ * a while and then goes away by itself - nothing has to wait for it to
+ * finish.
+ *
+ * An effect applies to a "target" - either a single LED matrix cell (see
+ * EFFECT_TARGET_CELL()) or something the game draws itself (such as 
+ * EFFECT_TARGET_BASE). The effects module doesn't know what is on the
+ * display, so:
+ * - code that draws a target asks effects_colour() what colour to use, and
+ * - whenever an effect changes what a target should look like (including
+ *   when the effect finishes) the redraw function given to effects_init()
+ *   is called for that target.
+ * effects_update() must be called regularly (e.g. each time around the 
+ * main loop) to move the effects along. When there are no effects 
+ * running, effects_update() and effects_colour() return straight away.
+ */
+
+#ifndef EFFECTS_H_
+#define EFFECTS_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+// Maximum number of effects which can be running at once. Starting another
+// effect when this many are running replaces the oldest one.
+#define MAX_EFFECTS 4
+
+// Effect types:
+// EFFECT_FLASH - the target is drawn in the effect colour for the whole time
+// EFFECT_BLINK - the target alternates between the effect colour and its
+//                own colour every EFFECT_BLINK_PERIOD milliseconds
+// EFFECT_FADE  - the target starts in the effect colour, which fades to 
+//                black in EFFECT_FADE_STEPS steps
+#define EFFECT_FLASH	0
+#define EFFECT_BLINK	1
+#define EFFECT_FADE		2
+
+#define EFFECT_BLINK_PERIOD	100
+#define EFFECT_FADE_STEPS	4
+
+// Targets. LED matrix cells are x (0 to 15) and y (0 to 7) as for 
+// ledmatrix_update_pixel(). EFFECT_TARGET_BASE is the base station.
+#define EFFECT_TARGET_CELL(x,y)		((uint8_t)(((x) << 3) | (y)))
+#define EFFECT_TARGET_X(target)		((target) >> 3)
+#define EFFECT_TARGET_Y(target)		((target) & 0x07)
+#define EFFECT_TARGET_IS_CELL(target)	((target) < 0x80)
+#define EFFECT_TARGET_BASE			0x80
+
+// Remove all effects and set the function to call when a target needs to
+// be redrawn. Effects are not redrawn when they're removed by this.
+void effects_init(void (*redraw)(uint8_t target));
+
+// Start an effect on the given target, lasting for duration milliseconds
+// from now. Any effect already running on the target is replaced. The 
+// target is redrawn straight away. (The time can be any millisecond
+// count, e.g. game time, as long as effects_update() is given the same.)
+void effects_start(uint8_t target, uint8_t type, PixelColour colour, 
+		uint16_t duration, uint32_t now);
+
+// Move the effects along to the given time, redrawing any targets which
+// need to change
+void effects_update(uint32_t now);
+
+// Return 1 if there is an effect running on the given target, 0 otherwise
+uint8_t effects_active(uint8_t target);
+
+// Return the colour the given target should be drawn in. colour is the 
+// colour it would be drawn in if there was no effect.
+PixelColour effects_colour(uint8_t target, PixelColour colour);
+
+#endif /* EFFECTS_H_ */
@@ -0,0 +1,70 @@
+/*
+ * font.h
+ *
+ * GENERATED FILE - DO NOT EDIT. This is produced from host/font.txt
+ * by host/fontgen.c, which describes the layout.
+ *
+ * Only to be included by scrolling_char_display.c.
+ */
+
+#ifndef FONT_H_
+#define FONT_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#define FONT_FIRST_CHAR 32
+#define FONT_LAST_CHAR 90
+
+static const uint8_t font_atlas[162] PROGMEM = {
+		/*   */ 0x00, 0x00,
+		/* ! */ 0xFA,
+		/* - */ 0x10, 0x10, 0x10,
+		/* . */ 0x02,
+		/* 0 */ 0x7C, 0x92, 0xA2, 0x7C,
+		/* 1 */ 0x42, 0xFE, 0x02,
+		/* 2 */ 0x46, 0x8A, 0x92, 0x62,
+		/* 3 */ 0x44, 0x92, 0x92, 0x6C,
+		/* 4 */ 0x18, 0x28, 0x48, 0xFE,
+		/* 5 */ 0xE4, 0xA2, 0xA2, 0x9C,
+		/* 6 */ 0x7C, 0x92, 0x92, 0x4C,
+		/* 7 */ 0x80, 0x9E, 0xA0, 0xC0,
+		/* 8 */ 0x6C, 0x92, 0x92, 0x6C,
+		/* 9 */ 0x64, 0x92, 0x92, 0x7C,
+		/* : */ 0x24,
+		/* ? */ 0x40, 0x8A, 0x90, 0x60,
+		/* A */ 0x7E, 0x90, 0x90, 0x7E,
+		/* B */ 0xFE, 0x92, 0x92, 0x6C,
+		/* C */ 0x7C, 0x82, 0x82, 0x44,
+		/* D */ 0xFE, 0x82, 0x82, 0x7C,
+		/* E */ 0xFE, 0x92, 0x92, 0x82,
+		/* F */ 0xFE, 0x90, 0x90, 0x80,
+		/* G */ 0x7C, 0x82, 0x92, 0x5C,
+		/* H */ 0xFE, 0x10, 0x10, 0xFE,
+		/* I */ 0x82, 0xFE, 0x82,
+		/* J */ 0x04, 0x02, 0x02, 0xFC,
+		/* K */ 0xFE, 0x10, 0x28, 0xC6,
+		/* L */ 0xFE, 0x02, 0x02, 0x02,
+		/* M */ 0xFE, 0x40, 0x30, 0x40, 0xFE,
+		/* N */ 0xFE, 0x20, 0x10, 0xFE,
+		/* O */ 0x7C, 0x82, 0x82, 0x7C,
+		/* P */ 0xFE, 0x90, 0x90, 0x60,
+		/* Q */ 0x7C, 0x82, 0x8A, 0x7C, 0x02,
+		/* R */ 0xFE, 0x90, 0x98, 0x66,
+		/* S */ 0x64, 0x92, 0x92, 0x4C,
+		/* T */ 0x80, 0x80, 0xFE, 0x80, 0x80,
+		/* U */ 0xFC, 0x02, 0x02, 0xFC,
+		/* V */ 0xF8, 0x04, 0x02, 0x04, 0xF8,
+		/* W */ 0xFC, 0x02, 0x1C, 0x02, 0xFC,
+		/* X */ 0xC6, 0x28, 0x10, 0x28, 0xC6,
+		/* Y */ 0xE0, 0x10, 0x0E, 0x10, 0xE0,
+		/* Z */ 0x86, 0x8A, 0x92, 0xA2, 0xC2 };
+
+static const uint8_t font_offsets[60] PROGMEM = {
+		  0,   2,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,
+		  3,   3,   6,   7,   7,  11,  14,  18,  22,  26,  30,  34,
+		 38,  42,  46,  47,  47,  47,  47,  47,  51,  51,  55,  59,
+		 63,  67,  71,  75,  79,  83,  86,  90,  94,  98, 103, 107,
+		111, 115, 120, 124, 128, 133, 137, 142, 147, 152, 157, 162 };
+
+#endif /* FONT_H_ */
@@ -20,9 +20,15 @@
 #include <avr/pgmspace.h>
 #include <stdio.h>
 #include "buttons.h"
+#include "prng.h"
+#include "bitmap.h"
+#include "effects.h"
+#include "compositor.h"
+#include "render.h"
+#include "tickstats.h"
 
 //uint8_t seven_seg[10] = { 63,6,91,79,102,109,125,7,127,111};
-/* Stdlib needed for random() - random number generator */
+
 
 ///////////////////////////////////////////////////////////
 // Colours
@@ -30,6 +36,15 @@
 #define COLOUR_PROJECTILE	COLOUR_RED
 #define COLOUR_BASE			COLOUR_YELLOW
 #define COLOUR_GAMEOVER		COLOUR_ORANGE
+#define COLOUR_BASE_HIT		COLOUR_ORANGE
+#define COLOUR_EXPLOSION	COLOUR_ORANGE
+
+// How long the base flashes for when it's hit by an asteroid, the cell 
+// where an asteroid is shot blinks for and an asteroid that hits the base
+// takes to fade away (milliseconds)
+#define BASE_HIT_FLASH_TIME	300
+#define EXPLOSION_TIME		400
+#define ASTEROID_FADE_TIME	400
 
 ///////////////////////////////////////////////////////////
 // Game positions (x,y) where x is 0 to 7 and y is 0 to 15
@@ -60,6 +75,10 @@
 #define LED_MATRIX_POSN_FROM_GAME_POSN(posn)		\
 		LED_MATRIX_POSN_FROM_XY(GET_X_POSITION(posn), GET_Y_POSITION(posn))
 
+// Effect target (see effects.h) for the LED matrix cell at a game position
+#define EFFECT_TARGET_FROM_GAME_POSN(posn)		\
+		EFFECT_TARGET_CELL(GET_Y_POSITION(posn), 7-GET_X_POSITION(posn))
+
 ///////////////////////////////////////////////////////////
 // Global variables.
 //
@@ -95,7 +114,6 @@ uint8_t		asteroids[MAX_ASTEROIDS];
 // Prototypes for internal information functions 
 //  - not available outside this module.
 volatile uint32_t temp;
-volatile uint32_t Right = 53;
 // Is there is an asteroid/projectile at the given position?. 
 // Returns -1 if no, asteroid/projectile index number if yes.
 // (The index number is the array index in the asteroids/
@@ -104,13 +122,19 @@ volatile uint32_t Right = 53;
 static int8_t asteroid_at(uint8_t x, uint8_t y);
 static int8_t projectile_at(uint8_t x, uint8_t y);
 
-// Remove the asteroid/projectile at the given index number. If
-// the index is not valid, then no removal is performed. This 
-// enables the functions to be used like:
-//		remove_asteroid(asteroid_at(x,y));
-static void remove_asteroid(int8_t asteroidIndex);
+// Remove the projectile at the given index number. If the index is
+// not valid, then no removal is performed. This enables the function
+// to be used like:
+//		remove_projectile(projectile_at(x,y));
+// (Asteroids are never removed - one that is hit or reaches the bottom
+// comes back in at the top, so there are always MAX_ASTEROIDS.)
 static void remove_projectile(int8_t projectileIndex);
 
+// Pick a random position (with no asteroid in it) for a new asteroid. This
+// is in the top row unless the top row is full, in which case the next row
+// down with space is used.
+static uint8_t new_asteroid_position(void);
+
 // Redraw functions
 static void redraw_whole_display(void);
 static void redraw_base(uint8_t colour);
@@ -118,6 +142,7 @@ static void redraw_all_asteroids(void);
 static void redraw_asteroid(uint8_t asteroidNumber, uint8_t colour);
 static void redraw_all_projectiles(void);
 static void redraw_projectile(uint8_t projectileNumber, uint8_t colour);
+static void redraw_effect_target(uint8_t target);
 
 ///////////////////////////////////////////////////////////
 
@@ -138,17 +163,25 @@ void initialise_game(void) {
 	numProjectiles = 0;
 	numAsteroids = 0;
 
+	// Reset the lives lost. (This is also done by is_game_over() but
+	// a game can finish without reaching game over, e.g. when a replay
+	// stops early.)
+	counter = 0;
+	temp = 0;
+	resetX(0);
+	effects_init(redraw_effect_target);
+
 	for(i=0; i < MAX_ASTEROIDS ; i++) {
 		// Generate random position that does not already
 		// have an asteroid.
 		do {
 			// Generate random x position - somewhere from 0
 			// to FIELD_WIDTH - 1
-			x = (uint8_t)(random() % FIELD_WIDTH);
+			x = prng_below(FIELD_WIDTH);
 			// Generate random y position - somewhere from 3
 			// to FIELD_HEIGHT - 1 (i.e., not in the lowest
 			// three rows)
-			y = (uint8_t)(3 + (random() % (FIELD_HEIGHT-3)));
+			y = 3 + prng_below(FIELD_HEIGHT-3);
 		} while(asteroid_at(x,y) != -1);
 		// If we get here, we've now found an x,y location without
 		// an existing asteroid - record the position
@@ -178,13 +211,11 @@ int8_t move_base(int8_t direction) {
 	if(direction == MOVE_LEFT ){
 		redraw_base(COLOUR_BLACK);
 		if (basePosition > 0) {
-			baseDisplayLeft();
 			basePosition--;
 		}
 		redraw_base(COLOUR_BASE);
 
 	}else{
-		baseDisplayRight();
 		redraw_base(COLOUR_BLACK);
 		if (basePosition < 7) {
 			basePosition++;
@@ -207,8 +238,7 @@ int8_t move_base(int8_t direction) {
 // Returns 1 if projectile fired, 0 otherwise.
 int8_t fire_projectile(void) {
 	uint8_t newProjectileNumber;
-	if(numProjectiles < MAX_PROJECTILES && 
-			projectile_at(basePosition, 2) == -1) {
+	if(can_fire()) {
 		// Have space to add projectile - add it at the x position of
 		// the base, in row 2(y=2)
 		newProjectileNumber = numProjectiles++;
@@ -223,7 +253,8 @@ int8_t fire_projectile(void) {
 // Move projectiles up by one position, and remove those that 
 // have gone off the top or that hit an asteroid.
 void advance_falling_astroid(void){
-	uint8_t pos_x,pos_y;
+	uint8_t pos_x;
+	int8_t pos_y;
 	int8_t asteroidNum;
 	asteroidNum = 0;
 	temp = 0; 
@@ -256,11 +287,8 @@ void advance_falling_astroid(void){
 				/////
 				/////////////////////////////////////////////////////////////////////////////
 				/// USE AN UNISIGNED INTEGER SO THAT THE LIVES DONT GO TO 0
-				int valScore = get_score();
-				move_cursor(14,12);
-				printf_P(PSTR("Score %d\n"),valScore);
-				move_cursor(14,13);
-				printf_P(PSTR("Lives Remaining %d\n"),lives);
+				render_score(get_score());
+				render_lives(lives);
 				if(lives == 0){
 					resetX(1);
 				}
@@ -270,48 +298,38 @@ void advance_falling_astroid(void){
 
 		//longest if statement in the world
 		if(pos_y == -1 || ( (pos_x == basePosition ) && (pos_y == 1) ) || ((pos_x == basePosition + 1) && (pos_y == 0)) || ((pos_x == basePosition -1) && (pos_y == 0)) ){
-						remove_asteroid(asteroidNum);
 			bool Base = false; 
 			if (pos_y != -1) {
 				//this is just testing
 				//add_to_score(10);
-				counter = counter + 1;
-				lifeLost(counter);
-				Base = true;
-				if(counter == 4){
-
+				// Once all the lives are gone further hits don't count
+				// (otherwise the number of lives left would wrap around)
+				if(counter < 4) {
+					counter = counter + 1;
+					lifeLost(counter);
 				}
-				
+				Base = true;
 			}
 
-			uint8_t x, y;
-
-			do {
-				x = (uint8_t)(random());
-				
-				y = (uint8_t)(FIELD_HEIGHT -1);
-			} while(asteroid_at(x,y) != -1);
-			
+			// The asteroid is taken off the field for now and comes back
+			// in at the top once all the others have moved (so it can't 
+			// land on a cell that another asteroid is about to move into)
+			redraw_asteroid(asteroidNum, COLOUR_BLACK);
 			if(Base == true){
-			asteroids[asteroidNum] = GAME_POSITION(x,y);
-			//Remove this printf_P(PSTR("Going to redraw asteroid\n"));
-			redraw_asteroid( (asteroidNum),  COLOUR_GREEN);
-			for (int d = 1; d <= 88; d++)
-			{redraw_base(COLOUR_ORANGE);}
-			}else{
-
-			asteroids[asteroidNum] = GAME_POSITION(x,y);
-			//Remove this printf_P(PSTR("Going to redraw asteroid\n"));
-			redraw_asteroid( (asteroidNum),  COLOUR_GREEN);
-			redraw_base(COLOUR_BASE);
+				// Flash the base and fade the asteroid out where it was -
+				// these are drawn by the effects module (see 
+				// redraw_effect_target()) and end by themselves
+				effects_start(EFFECT_TARGET_BASE, EFFECT_FLASH, COLOUR_BASE_HIT,
+						BASE_HIT_FLASH_TIME, last_move_time());
+				effects_start(EFFECT_TARGET_FROM_GAME_POSN(asteroids[asteroidNum]),
+						EFFECT_FADE, COLOUR_ASTEROID, ASTEROID_FADE_TIME,
+						last_move_time());
 			}
-
-
+			asteroids[asteroidNum] = INVALID_POSITION;
 		}else{
 			redraw_asteroid(asteroidNum,COLOUR_BLACK);
 			asteroids[asteroidNum] = GAME_POSITION(pos_x,pos_y);
 			redraw_asteroid(asteroidNum, COLOUR_GREEN);
-						redraw_base(COLOUR_BASE);
 
 
 		}
@@ -320,7 +338,37 @@ void advance_falling_astroid(void){
 
 	}
 	
+	// Bring back the asteroids that reached the bottom or hit the base
+	for(asteroidNum = 0; asteroidNum < numAsteroids; asteroidNum++) {
+		if(asteroids[asteroidNum] == INVALID_POSITION) {
+			asteroids[asteroidNum] = new_asteroid_position();
+			redraw_asteroid(asteroidNum, COLOUR_ASTEROID);
+		}
+	}
 }
+
+// If there is an asteroid at the given position the projectile with the 
+// given number has hit it - both are removed, a new asteroid comes in at
+// the top and the score goes up. Returns 1 if there was a hit, 0 if not.
+static uint8_t projectile_hit(int8_t projectileNumber, uint8_t x, uint8_t y) {
+	int8_t asteroidNumber = asteroid_at(x, y);
+	
+	if(asteroidNumber == -1) {
+		return 0;
+	}
+	remove_projectile(projectileNumber);
+	redraw_asteroid(asteroidNumber, COLOUR_BLACK);
+	// The cell where the asteroid was blinks (drawn by the effects module)
+	effects_start(EFFECT_TARGET_FROM_GAME_POSN(asteroids[asteroidNumber]),
+			EFFECT_BLINK, COLOUR_EXPLOSION, EXPLOSION_TIME, last_move_time());
+	asteroids[asteroidNumber] = new_asteroid_position();
+	redraw_asteroid(asteroidNumber, COLOUR_ASTEROID);
+
+	add_to_score((uint32_t)1);
+	render_score(get_score());
+	return 1;
+}
+
 void advance_projectiles(void) {
 	uint8_t x, y;
 	int8_t projectileNumber;
@@ -331,62 +379,11 @@ void advance_projectiles(void) {
 		x = GET_X_POSITION(projectiles[projectileNumber]);
 		y = GET_Y_POSITION(projectiles[projectileNumber]);
 		
-		// Work out the new position (but don't update the projectile 
-		// location yet - we only do that if we know the move is valid)
-		
-		for (int8_t i = 0; i < sizeof(asteroids); i++) {
-			// get asteroid x and y
-			uint8_t xA = GET_X_POSITION(asteroids[i]);
-			uint8_t yA = GET_Y_POSITION(asteroids[i]);
-
-			if (x == xA && y==yA) {				
-			// collision detected
-			//remove this
-			//printf_P(PSTR("collision detected\n"));
-				remove_projectile(projectileNumber);
-				remove_asteroid(i);
-
-				add_to_score((uint32_t)1);
-
-				
-
-				//int characterScore = get_score();
-
-				//sprintf(*p, "%d",characterScore);
-				//printf_P(PSTR("\n"),characterScore);
-
-				
-
-				//uint8_t digit;
-				/* Set port A pins to be outputs, port C pins to be inputs */
-				//DDRA = 0xFF;
-				//DDRC = 0;
-				//DDRC = 0; /* This is the default, could omit. */
-				/* Read in a digit from lower half of port C pins */
-				/* We read the whole byte and mask out upper bits */
-				//digit = (uint8_t)get_score();
-				/* Write out seven segment display value to port A */
-
-				//if(digit < 10) {
-					//PORTA = seven_seg[digit];
-					//} else {
-					//PORTA = 0;
-				//}
-
-				uint8_t x, y;
-
-				do {
-					x = (uint8_t)(random() % FIELD_WIDTH);
-					
-					y = (uint8_t)((FIELD_HEIGHT-1));
-				} while(asteroid_at(x,y) != -1);
-				
-				asteroids[numAsteroids++] = GAME_POSITION(x,y);
-				//Remove this printf_P(PSTR("Going to redraw asteroid\n"));
-				redraw_asteroid( (numAsteroids - 1),  COLOUR_GREEN);
-				//redraw_whole_display();
-			}
-
+		// If an asteroid has moved down on to the projectile it's a hit.
+		// (The projectile is removed, so projectileNumber is now the next
+		// projectile, if any.)
+		if(projectile_hit(projectileNumber, x, y)) {
+			continue;
 		}
 
 		// Check if new position would be off the top of the display
@@ -404,12 +401,14 @@ void advance_projectiles(void) {
 			// decreased by 1
 		} else {
 					y = y+1;
-			// Projectile is not going off the top of the display
-			// CHECK HERE IF THE NEW PROJECTILE LOCATION CORRESPONDS TO
-			// AN ASTEROID LOCATION. IF IT DOES, REMOVE THE PROJECTILE
-			// AND THE ASTEROID.
+			// Projectile is not going off the top of the display. If
+			// the new location has an asteroid in it, the projectile
+			// and the asteroid are both removed.
+			if(projectile_hit(projectileNumber, x, y)) {
+				continue;
+			}
 			
-			// OTHERWISE...
+			// Otherwise...
 			
 			// Remove the projectile from the display 
 			redraw_projectile(projectileNumber, COLOUR_BLACK);
@@ -428,13 +427,42 @@ void advance_projectiles(void) {
 	}
 }
 
+int8_t get_base_position(void) {
+	return basePosition;
+}
+
+int8_t lowest_asteroid(uint8_t x) {
+	int8_t lowest = -1;
+	for(uint8_t i = 0; i < numAsteroids; i++) {
+		if(GET_X_POSITION(asteroids[i]) == x && 
+				(lowest == -1 || GET_Y_POSITION(asteroids[i]) < lowest)) {
+			lowest = GET_Y_POSITION(asteroids[i]);
+		}
+	}
+	return lowest;
+}
+
+uint8_t projectiles_in_column(uint8_t x) {
+	uint8_t count = 0;
+	for(uint8_t i = 0; i < numProjectiles; i++) {
+		count += (GET_X_POSITION(projectiles[i]) == x);
+	}
+	return count;
+}
+
+// We can fire if we haven't reached the maximum number of projectiles
+// and there isn't already a projectile immediately above the base
+uint8_t can_fire(void) {
+	return numProjectiles < MAX_PROJECTILES && 
+			projectile_at(basePosition, 2) == -1;
+}
+
 // Returns 1 if the game is over, 0 otherwise. Initially, the game is
 // never over.
 int8_t is_game_over(void) {
 	if(returnGameState() == 1){
 		counter = 0;
 		temp = 0;
-		Right = 53;
 		return 1;
 	}
 
@@ -442,6 +470,101 @@ int8_t is_game_over(void) {
 }
 
 
+// Game clock - see game.h. projectileMoveTime and asteroidMoveTime are
+// the game times at which the projectiles and asteroids next move.
+// FasterGame is taken off the time between asteroid moves once the 
+// score passes 10 - so the game speeds up. highSpeed and speedHeld are
+// the high speed mode settings.
+static uint32_t projectileMoveTime;
+static uint32_t asteroidMoveTime;
+static uint32_t lastMoveTime;
+static uint32_t pausedTime;
+static int16_t FasterGame;
+static uint8_t highSpeed;
+static uint8_t speedHeld;
+
+void start_game_clock(void) {
+	FasterGame = 0;
+	highSpeed = 0;
+	speedHeld = 0;
+	projectileMoveTime = PROJECTILE_PERIOD;
+	asteroidMoveTime = ASTEROID_PERIOD;
+	lastMoveTime = 0;
+}
+
+int8_t advance_game(uint32_t now) {
+	// If both are due at the same time the projectiles move first
+	if(projectileMoveTime <= asteroidMoveTime) {
+		if(projectileMoveTime > now) {
+			return 0;
+		}
+		lastMoveTime = projectileMoveTime;
+		TICK_STATS_BEGIN();
+		advance_projectiles();
+		TICK_STATS_END(TICK_PHASE_PROJECTILES);
+		projectileMoveTime += PROJECTILE_PERIOD;
+	} else {
+		if(asteroidMoveTime > now) {
+			return 0;
+		}
+		lastMoveTime = asteroidMoveTime;
+		if(get_score() > 10 && !speedHeld && FasterGame < 
+				(highSpeed ? ASTEROID_PERIOD - HIGH_SPEED_MIN_PERIOD : 400)) {
+			FasterGame = FasterGame + 10;
+		}
+		// Once past 100 the speed-up jumps to 200 - and stays there 
+		// unless we're in high speed mode
+		if(FasterGame > 100 && (FasterGame < 200 || !highSpeed)) {
+			FasterGame = 200;
+		}
+		TICK_STATS_BEGIN();
+		advance_falling_astroid();
+		TICK_STATS_END(TICK_PHASE_ASTEROIDS);
+		asteroidMoveTime += ASTEROID_PERIOD - FasterGame;
+	}
+	return 1;
+}
+
+uint32_t next_move_time(void) {
+	if(projectileMoveTime <= asteroidMoveTime) {
+		return projectileMoveTime;
+	}
+	return asteroidMoveTime;
+}
+
+uint32_t last_move_time(void) {
+	return lastMoveTime;
+}
+
+uint16_t asteroid_period(void) {
+	return ASTEROID_PERIOD - FasterGame;
+}
+
+void toggle_high_speed(void) {
+	highSpeed = !highSpeed;
+}
+
+uint8_t high_speed(void) {
+	return highSpeed;
+}
+
+void hold_speed(void) {
+	speedHeld = 1;
+}
+
+uint8_t speed_held(void) {
+	return speedHeld;
+}
+
+void pause_game_clock(uint32_t now) {
+	pausedTime = now;
+}
+
+void resume_game_clock(uint32_t now) {
+	projectileMoveTime += now - pausedTime;
+	asteroidMoveTime += now - pausedTime;
+}
+
 /******** INTERNAL FUNCTIONS ****************/
 
 // Check whether there is an asteroid at a given position.
@@ -476,25 +599,26 @@ static int8_t projectile_at(uint8_t x, uint8_t y) {
 	return -1;
 }
 
-/* Remove asteroid with the given index number (from 0 to
-** numAsteroids - 1).
-*/
-static void remove_asteroid(int8_t asteroidNumber) {
-	if(asteroidNumber < 0 || asteroidNumber >= numAsteroids) {
-		// Invalid index - do nothing
-		return;
-	}
-	
-	// Remove the asteroid from the display
-	redraw_asteroid(asteroidNumber, COLOUR_BLACK);
+static uint8_t new_asteroid_position(void) {
+	uint8_t x, y, freeCells, choice;
 	
-	if(asteroidNumber < numAsteroids - 1) {
-		// Asteroid is not the last one in the list
-		// - move the last one in the list to this position
-		asteroids[asteroidNumber] = asteroids[numAsteroids - 1];
+	for(y = FIELD_HEIGHT - 1; y >= 3; y--) {
+		freeCells = 0;
+		for(x = 0; x < FIELD_WIDTH; x++) {
+			freeCells += (asteroid_at(x, y) == -1);
+		}
+		if(freeCells) {
+			// Choose one of the free cells in this row
+			choice = prng_below(freeCells);
+			for(x = 0; x < FIELD_WIDTH; x++) {
+				if(asteroid_at(x, y) == -1 && choice-- == 0) {
+					return GAME_POSITION(x, y);
+				}
+			}
+		}
 	}
-	// Last position in asteroids array is no longer used
-	numAsteroids--;
+	// Can't get here - there are far fewer asteroids than cells
+	return INVALID_POSITION;
 }
 
 // Remove projectile with the given projectile number (from 0 to
@@ -520,8 +644,12 @@ static void remove_projectile(int8_t projectileNumber) {
 // Redraw the whole display - base, asteroids and projectiles.
 // We assume all of the data structures have been appropriately poplulated
 static void redraw_whole_display(void) {
-	// clear the display
-	ledmatrix_clear();
+	// clear the display and start again with empty layers
+	render_clear();
+	compositor_init();
+	compositor_set_layer_colour(LAYER_BASE, COLOUR_BASE);
+	compositor_set_layer_colour(LAYER_ASTEROID, COLOUR_ASTEROID);
+	compositor_set_layer_colour(LAYER_PROJECTILE, COLOUR_PROJECTILE);
 	
 	// Redraw each of the elements
 	redraw_base(COLOUR_BASE);
@@ -529,15 +657,27 @@ static void redraw_whole_display(void) {
 	redraw_all_projectiles();
 }
 
+// The redraw functions below don't draw directly on the LED matrix, they
+// add things to (or, if the colour is COLOUR_BLACK, remove them from)
+// the compositor layers. What is shown on the LED matrix is only 
+// updated when compositor_flush() is called. Each layer has its own
+// colour (set in redraw_whole_display()) so other colours are ignored.
+
 static void redraw_base(uint8_t colour){
+	// The base is the only thing in its layer - we start the layer
+	// again each time
+	compositor_clear_layer(LAYER_BASE);
+	if(colour == COLOUR_BLACK) {
+		return;
+	}
 	// Add the bottom row of the base first (0) followed by the single bit
 	// in the next row (1)
 	for(int8_t x = basePosition - 1; x <= basePosition+1; x++) {
 		if (x >= 0 && x < FIELD_WIDTH) {
-			ledmatrix_update_pixel(LED_MATRIX_POSN_FROM_XY(x, 0), colour);
+			compositor_set(LAYER_BASE, LED_MATRIX_POSN_FROM_XY(x, 0));
 		}
 	}
-	ledmatrix_update_pixel(LED_MATRIX_POSN_FROM_XY(basePosition, 1), colour);
+	compositor_set(LAYER_BASE, LED_MATRIX_POSN_FROM_XY(basePosition, 1));
 }
 
 static void redraw_all_asteroids(void) {
@@ -551,7 +691,18 @@ static void redraw_asteroid(uint8_t asteroidNumber, uint8_t colour) {
 	uint8_t asteroidPosn;
 	if(asteroidNumber < numAsteroids) {
 		asteroidPosn = asteroids[asteroidNumber];
-		ledmatrix_update_pixel(LED_MATRIX_POSN_FROM_GAME_POSN(asteroidPosn), colour);
+		if(colour != COLOUR_BLACK) {
+			compositor_set(LAYER_ASTEROID, LED_MATRIX_POSN_FROM_GAME_POSN(asteroidPosn));
+			return;
+		}
+		// Only take the cell out of the layer if there isn't another
+		// asteroid in it
+		for(uint8_t i = 0; i < numAsteroids; i++) {
+			if(i != asteroidNumber && asteroids[i] == asteroidPosn) {
+				return;
+			}
+		}
+		compositor_clear(LAYER_ASTEROID, LED_MATRIX_POSN_FROM_GAME_POSN(asteroidPosn));
 	}
 }
 
@@ -568,140 +719,121 @@ static void redraw_projectile(uint8_t projectileNumber, uint8_t colour) {
 	// Check projectileNumber is valid - ignore otherwise
 	if(projectileNumber < numProjectiles) {
 		projectilePosn = projectiles[projectileNumber];
-		ledmatrix_update_pixel(LED_MATRIX_POSN_FROM_GAME_POSN(projectilePosn), colour);
-	}
-}
-
-void baseDisplayRight(void){
-	if(Right < 60){
-	Right = Right + 2;
-	 move_cursor(40,19);
-	clear_to_end_of_line();
-	 move_cursor(Right,19);
-	printf_P(PSTR("_|_"));
-    move_cursor(47,19);
-	printf_P(PSTR("#"));
-	move_cursor(62,19);
-	printf_P(PSTR("#"));
-	}
-	if(Right > 59){
-	move_cursor(40,19);
-	clear_to_end_of_line();
-	move_cursor(47,19);
-	printf_P(PSTR("#"));
-	move_cursor(62,19);
-	printf_P(PSTR("#"));
-	 move_cursor(60,19);
-	 printf_P(PSTR("_|"));
-
+		if(colour != COLOUR_BLACK) {
+			compositor_set(LAYER_PROJECTILE, LED_MATRIX_POSN_FROM_GAME_POSN(projectilePosn));
+			return;
+		}
+		// Only take the cell out of the layer if there isn't another
+		// projectile in it
+		for(uint8_t i = 0; i < numProjectiles; i++) {
+			if(i != projectileNumber && projectiles[i] == projectilePosn) {
+				return;
+			}
+		}
+		compositor_clear(LAYER_PROJECTILE, LED_MATRIX_POSN_FROM_GAME_POSN(projectilePosn));
 	}
-
 }
-void baseDisplayLeft(void){
-	if(Right >46){
-		Right = Right - 2;
-		move_cursor(40,19);
-		clear_to_end_of_line();
-		move_cursor(Right,19);
-		printf_P(PSTR("_|_"));
-		move_cursor(47,19);
-		printf_P(PSTR("#"));
-		move_cursor(62,19);
-		printf_P(PSTR("#"));
 
-		
-	}
-	if(Right <47){
-	move_cursor(40,19);
-	clear_to_end_of_line();
-	move_cursor(47,19);
-	printf_P(PSTR("#"));
-	move_cursor(62,19);
-	printf_P(PSTR("#"));
-	move_cursor(48,19);
-	printf_P(PSTR("|_"));
+// Called by the effects module when something with an effect on it needs
+// to be redrawn (see effects.h)
+static void redraw_effect_target(uint8_t target) {
+	uint8_t x, y;
+	
+	if(target == EFFECT_TARGET_BASE) {
+		// The base flashes by changing the colour of its layer
+		compositor_set_layer_colour(LAYER_BASE, 
+				effects_colour(EFFECT_TARGET_BASE, COLOUR_BASE));
+	} else if(EFFECT_TARGET_IS_CELL(target)) {
+		// Cell effects go in the effect layer while they're running
+		x = EFFECT_TARGET_X(target);
+		y = EFFECT_TARGET_Y(target);
+		if(effects_active(target)) {
+			compositor_set(LAYER_EFFECT, x, y);
+		} else {
+			compositor_clear(LAYER_EFFECT, x, y);
+		}
 	}
-
 }
 
-void animation(void){
-for(int i = 0; i < 15000; i++){	
-	uint8_t x, y;
-	uint8_t x1, y1;
-
-	x = (uint8_t)(random());
-	
-	y = (uint8_t)(random());
-	
-	x1 = (uint8_t)(random());
+// Game over animation. This is a state machine which is moved on by
+// update_game_over_animation() - each call does at most one frame's worth
+// of work and returns, so the caller can keep checking for input (and
+// stop the animation whenever it likes).
+//
+// The animation is ANIMATION_SPARKLE_FRAMES frames of random orange
+// pixels, followed by the word "END" which is shown for ANIMATION_END_TIME
+// milliseconds before the display is cleared.
+#define ANIMATION_FRAME_TIME		50
+#define ANIMATION_SPARKLE_FRAMES	20
+#define ANIMATION_END_TIME			1200
+
+#define ANIMATION_SPARKLE	0
+#define ANIMATION_SHOW_END	1
+#define ANIMATION_DONE		2
+
+// "END" - one byte per LED matrix column, see bitmap.h
+static const uint8_t end_bitmap[MATRIX_NUM_COLUMNS] PROGMEM = {
+		0x00, 0x3C, 0x42, 0x7E, 0x00, 0x7E, 0x40, 0x7E,
+		0x02, 0x7E, 0x00, 0x4A, 0x4A, 0x7E, 0x00, 0x00 };
+
+static uint8_t animationState = ANIMATION_DONE;
+static uint8_t animationFrame;
+static uint32_t animationTime;
+
+static void draw_sparkle_frame(void) {
+	MatrixData data;
+	uint16_t r = 0;
 	
-	y1 = (uint8_t)(random());
-
-
-	ledmatrix_update_pixel(x,y,COLOUR_ORANGE);
-	ledmatrix_update_pixel(x1,y1,COLOUR_LIGHT_ORANGE);
+	// Each pixel gets two random bits - half the pixels are off and the
+	// rest are orange or light orange. One random number does 8 pixels.
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			if((y & 7) == 0) {
+				r = prng_next();
+			}
+			switch(r & 3) {
+				case 2:
+					data[x][y] = COLOUR_ORANGE;
+					break;
+				case 3:
+					data[x][y] = COLOUR_LIGHT_ORANGE;
+					break;
+				default:
+					data[x][y] = COLOUR_BLACK;
+			}
+			r >>= 2;
+		}
+	}
+	ledmatrix_update_all(data);
 }
 
-	ledmatrix_clear();
-
-for(int i = 0; i < 78; i++){ ///cghange i to 80
-	//E
-	ledmatrix_update_pixel(13,6,COLOUR_ORANGE);
-    ledmatrix_update_pixel(13,5,COLOUR_ORANGE);
-	ledmatrix_update_pixel(13,4,COLOUR_ORANGE);
-	ledmatrix_update_pixel(13,3,COLOUR_ORANGE);
-	ledmatrix_update_pixel(13,2,COLOUR_ORANGE);
-	ledmatrix_update_pixel(13,1,COLOUR_ORANGE);
-	ledmatrix_update_pixel(12,1,COLOUR_ORANGE);
-	ledmatrix_update_pixel(11,1,COLOUR_ORANGE);
-	ledmatrix_update_pixel(12,1,COLOUR_ORANGE);
-	ledmatrix_update_pixel(12,3,COLOUR_ORANGE);
-	ledmatrix_update_pixel(11,3,COLOUR_ORANGE);
-	ledmatrix_update_pixel(12,6,COLOUR_ORANGE);
-	ledmatrix_update_pixel(11,6,COLOUR_ORANGE);
-	//N
-	ledmatrix_update_pixel(9,6,COLOUR_ORANGE);
-	ledmatrix_update_pixel(9,5,COLOUR_ORANGE);
-	ledmatrix_update_pixel(9,4,COLOUR_ORANGE);
-	ledmatrix_update_pixel(9,3,COLOUR_ORANGE);
-	ledmatrix_update_pixel(9,2,COLOUR_ORANGE);
-	ledmatrix_update_pixel(9,1,COLOUR_ORANGE);
-
-	ledmatrix_update_pixel(8,1,COLOUR_ORANGE);
-	ledmatrix_update_pixel(7,1,COLOUR_ORANGE);
-
-	ledmatrix_update_pixel(7,2,COLOUR_ORANGE);
-	ledmatrix_update_pixel(7,3,COLOUR_ORANGE);
-	ledmatrix_update_pixel(7,4,COLOUR_ORANGE);
-	ledmatrix_update_pixel(7,5,COLOUR_ORANGE);
-	ledmatrix_update_pixel(7,6,COLOUR_ORANGE);
-	ledmatrix_update_pixel(6,6,COLOUR_ORANGE);
-	ledmatrix_update_pixel(5,6,COLOUR_ORANGE);
-	ledmatrix_update_pixel(5,4,COLOUR_ORANGE);
-	ledmatrix_update_pixel(5,5,COLOUR_ORANGE);
-	ledmatrix_update_pixel(5,3,COLOUR_ORANGE);
-	ledmatrix_update_pixel(5,2,COLOUR_ORANGE);
-	ledmatrix_update_pixel(5,1,COLOUR_ORANGE);
-
-	//D
-	ledmatrix_update_pixel(3,1,COLOUR_ORANGE);
-		ledmatrix_update_pixel(2,6,COLOUR_ORANGE);
-
-	ledmatrix_update_pixel(3,2,COLOUR_ORANGE);
-	ledmatrix_update_pixel(3,3,COLOUR_ORANGE);
-	ledmatrix_update_pixel(3,4,COLOUR_ORANGE);
-	ledmatrix_update_pixel(3,5,COLOUR_ORANGE);
-	ledmatrix_update_pixel(3,6,COLOUR_ORANGE);
-		ledmatrix_update_pixel(2,1,COLOUR_ORANGE);
-				ledmatrix_update_pixel(1,2,COLOUR_ORANGE);
-								ledmatrix_update_pixel(1,3,COLOUR_ORANGE);
-												ledmatrix_update_pixel(1,4,COLOUR_ORANGE);
-												ledmatrix_update_pixel(1,5,COLOUR_ORANGE);
-
-
+void start_game_over_animation(uint32_t now) {
+	animationState = ANIMATION_SPARKLE;
+	animationFrame = 0;
+	// Make the first frame due straight away
+	animationTime = now - ANIMATION_FRAME_TIME;
 }
 
-
+uint8_t update_game_over_animation(uint32_t now) {
+	switch(animationState) {
+		case ANIMATION_SPARKLE:
+			if(now - animationTime >= ANIMATION_FRAME_TIME) {
+				animationTime = now;
+				if(animationFrame < ANIMATION_SPARKLE_FRAMES) {
+					draw_sparkle_frame();
+					animationFrame++;
+				} else {
+					bitmap_show(end_bitmap, COLOUR_ORANGE);
+					animationState = ANIMATION_SHOW_END;
+				}
+			}
+			break;
+		case ANIMATION_SHOW_END:
+			if(now - animationTime >= ANIMATION_END_TIME) {
+				ledmatrix_clear();
+				animationState = ANIMATION_DONE;
+			}
+			break;
+	}
+	return animationState != ANIMATION_DONE;
 }
-
-
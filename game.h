@@ -29,6 +29,27 @@
 #define MOVE_LEFT 0
 #define MOVE_RIGHT 1
 
+// Game inputs - what button pushes and serial input are decoded to. These
+// are what is recorded and replayed (see replay.h). INPUT_LEFT and 
+// INPUT_RIGHT match MOVE_LEFT and MOVE_RIGHT.
+#define INPUT_NONE	(-1)
+#define INPUT_LEFT	0
+#define INPUT_RIGHT	1
+#define INPUT_FIRE	2
+#define INPUT_PAUSE	3
+// Turn high speed mode on or off, and stop the game getting any faster 
+// (see high_speed() below)
+#define INPUT_HIGH_SPEED	4
+#define INPUT_HOLD_SPEED	5
+
+// Time between projectile moves, and between asteroid moves at the start
+// of the game (milliseconds)
+#define PROJECTILE_PERIOD	500
+#define ASTEROID_PERIOD		500
+
+// Shortest time between asteroid moves in high speed mode (milliseconds)
+#define HIGH_SPEED_MIN_PERIOD	50
+
 // Initialise the game and output the initial display
 void initialise_game(void); 
 
@@ -47,10 +68,69 @@ int8_t fire_projectile(void);
 // go off the top or that hit an asteroid are removed.
 void advance_falling_astroid(void);
 void advance_projectiles(void);
-void baseDisplayRight(void);
-void baseDisplayLeft(void);
 // Returns 1 if the game is over, 0 otherwise
 int8_t is_game_over(void);
-void animation(void);
+
+// Game state, for the autopilot (see autopilot.h).
+// get_base_position() returns the x position of the centre of the base
+// (0 to 7). lowest_asteroid() returns the y position of the lowest 
+// asteroid in column x, or -1 if there are none in that column. 
+// projectiles_in_column() returns the number of projectiles in flight in
+// column x, and can_fire() returns 1 if fire_projectile() would succeed.
+int8_t get_base_position(void);
+int8_t lowest_asteroid(uint8_t x);
+uint8_t projectiles_in_column(uint8_t x);
+uint8_t can_fire(void);
+
+// Game clock. Game time is measured in milliseconds from the start of 
+// the game. Projectiles and asteroids move at fixed game times - if a
+// move happens late (e.g. because the previous one took a long time)
+// then the one after is not delayed. This means the game only depends on
+// the inputs and the game times at which they happen, not on how long
+// things take to run (so a game can be recorded and replayed exactly).
+//
+// start_game_clock() must be called at game time 0 (after 
+// initialise_game()). advance_game() performs the next projectile or
+// asteroid move if it is due at or before the given time and returns 1
+// if it did so, 0 otherwise. It should be called repeatedly until it 
+// returns 0 so that all moves which are due happen (in order) before
+// any input at that time is dealt with.
+void start_game_clock(void);
+int8_t advance_game(uint32_t now);
+
+// Game time at which the next move is due, and at which the most recent
+// move was due
+uint32_t next_move_time(void);
+uint32_t last_move_time(void);
+
+// Time between asteroid moves (milliseconds) - ASTEROID_PERIOD to start
+// with, less once the game has sped up
+uint16_t asteroid_period(void);
+
+// High speed mode. Once the score passes 10 the game speeds up with each
+// asteroid move - normally to an asteroid period of 300ms at most, but in
+// high speed mode it carries on down to HIGH_SPEED_MIN_PERIOD. 
+// hold_speed() stops it getting any faster for the rest of the game (if
+// the board can't keep up - see highspeed.h). Both are game inputs 
+// (INPUT_HIGH_SPEED and INPUT_HOLD_SPEED) so that they are recorded, and 
+// both are turned off by start_game_clock().
+void toggle_high_speed(void);
+uint8_t high_speed(void);
+void hold_speed(void);
+uint8_t speed_held(void);
+
+// Stop and restart the game clock (when the game is paused) - moves that
+// were due are put back by the length of the pause.
+void pause_game_clock(uint32_t now);
+void resume_game_clock(uint32_t now);
+
+// Game over animation. start_game_over_animation() starts it and
+// update_game_over_animation() must then be called frequently (with the
+// current time in milliseconds) to move it along. It returns 1 while the 
+// animation is still running and 0 once it's finished. Each call takes
+// at most a few milliseconds. The animation can be abandoned at any time
+// by just not calling update_game_over_animation() any more.
+void start_game_over_animation(uint32_t now);
+uint8_t update_game_over_animation(uint32_t now);
 
 #endif
@@ -0,0 +1,106 @@
+/*
+ * highspeed.c
+ *
+ * High speed mode - see highspeed.h
+ */
+
+#include <stdint.h>
+
+#include <avr/pgmspace.h>
+
+#include "highspeed.h"
+#include "display.h"
+#include "game.h"
+#include "render.h"
+#include "replay.h"
+#include "timer0.h"
+
+static uint8_t chosen;
+
+// The tick under way - when it started (microseconds) and the game time
+// of the last move before it
+static uint8_t inTick;
+static uint32_t tickStart;
+static uint32_t tickMoveTime;
+
+// Number of ticks in a row that took too long, whether the terminal field
+// has been turned off and whether the game should be held at its speed
+static uint8_t overloaded;
+static uint8_t fieldOff;
+static uint8_t holdWanted;
+
+void highspeed_choose(uint8_t on) {
+	chosen = on;
+}
+
+uint8_t highspeed_chosen(void) {
+	return chosen;
+}
+
+static void terminal_field_on(void) {
+	if(fieldOff) {
+		fieldOff = 0;
+		display_terminal_field(1);
+	}
+}
+
+void highspeed_start_game(void) {
+	inTick = 0;
+	overloaded = 0;
+	holdWanted = 0;
+	terminal_field_on();
+}
+
+void highspeed_start_tick(void) {
+	if(inTick || replay_playing()) {
+		return;
+	}
+	if(!high_speed()) {
+		// The mode has been turned off - back to normal output
+		terminal_field_on();
+		return;
+	}
+	inTick = 1;
+	tickMoveTime = last_move_time();
+	tickStart = get_current_time_us();
+}
+
+void highspeed_end_tick(void) {
+	uint32_t limit;
+
+	if(!inTick) {
+		return;
+	}
+	inTick = 0;
+	// Only ticks that moved something count - the rest do little more
+	// than check for input
+	if(last_move_time() == tickMoveTime) {
+		return;
+	}
+	limit = (uint32_t)asteroid_period() * 1000 / HIGH_SPEED_LOAD_DIVISOR;
+	if(get_current_time_us() - tickStart <= limit) {
+		overloaded = 0;
+		return;
+	}
+	if(++overloaded < HIGH_SPEED_OVERLOADED) {
+		return;
+	}
+	overloaded = 0;
+	if(!fieldOff) {
+		fieldOff = 1;
+		display_terminal_field(0);
+		render_message(PSTR("HIGH SPEED - TERMINAL FIELD OFF"));
+	} else {
+		holdWanted = 1;
+	}
+}
+
+int8_t highspeed_next_input(void) {
+	if(high_speed() != chosen) {
+		return INPUT_HIGH_SPEED;
+	}
+	if(holdWanted && high_speed() && !speed_held()) {
+		return INPUT_HOLD_SPEED;
+	}
+	return INPUT_NONE;
+}
@@ -0,0 +1,57 @@
+/*
+ * highspeed.h
+ *
+ * High speed mode - lets the game speed up to an asteroid period of
+ * HIGH_SPEED_MIN_PERIOD (see high_speed() in game.h) instead of stopping
+ * at 300ms. It is chosen with 'h' and stays chosen for later games.
+ *
+ * Turning the mode on and off is a game input (INPUT_HIGH_SPEED) so that
+ * it is recorded - highspeed_next_input() gives the input whenever the
+ * game's mode isn't the one chosen (e.g. at the start of each game).
+ *
+ * At the faster speeds the output for a tick (mostly the terminal) can
+ * take longer than the time between asteroid moves, which would make the
+ * asteroids late and the controls sluggish. So while the mode is on, the
+ * time taken by each tick (one pass of play_game()'s loop that ends with
+ * the frame being shown, including any passes before it that only moved
+ * things - as for tickstats.h) is measured. If HIGH_SPEED_OVERLOADED ticks
+ * in a row that moved something take longer than the asteroid period
+ * divided by HIGH_SPEED_LOAD_DIVISOR (so input is still dealt with well
+ * within each period):
+ *   - first the copy of the playing field on the terminal is no longer
+ *     drawn (see display_terminal_field() - the LED matrix still shows
+ *     every frame in full)
+ *   - then, if that's not enough, the game is held at its current speed
+ *     for the rest of the game (INPUT_HOLD_SPEED - an input so that the
+ *     game still replays exactly)
+ * None of this is done while replaying, when a replay decides it instead.
+ */
+
+#ifndef HIGHSPEED_H_
+#define HIGHSPEED_H_
+
+#include <stdint.h>
+
+#define HIGH_SPEED_LOAD_DIVISOR	2
+#define HIGH_SPEED_OVERLOADED	3
+
+// Choose high speed mode (1) or not (0) - takes effect in the game
+// through highspeed_next_input()
+void highspeed_choose(uint8_t on);
+uint8_t highspeed_chosen(void);
+
+// Must be called at the start of each game - the terminal field is
+// turned back on
+void highspeed_start_game(void);
+
+// Called at the top of play_game()'s loop and once the frame has been
+// shown, to measure the ticks
+void highspeed_start_tick(void);
+void highspeed_end_tick(void);
+
+// Returns INPUT_HIGH_SPEED if the game's mode needs to change to the one
+// chosen, INPUT_HOLD_SPEED if the game can't keep up at its current
+// speed, INPUT_NONE otherwise
+int8_t highspeed_next_input(void);
+
+#endif /* HIGHSPEED_H_ */
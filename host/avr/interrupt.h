@@ -0,0 +1,19 @@
+/*
+ * avr/interrupt.h (host shim)
+ *
+ * Interrupt service routines become ordinary functions which a host
+ * program can call to simulate the interrupt firing. cli() and sei()
+ * just update the I bit in the simulated status register.
+ */
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define ISR(vector)	void vector(void); void vector(void)
+
+#define cli()	(SREG &= (uint8_t)~_BV(SREG_I))
+#define sei()	(SREG |= _BV(SREG_I))
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
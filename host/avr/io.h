@@ -0,0 +1,88 @@
+/*
+ * avr/io.h (host shim)
+ *
+ * Stand-in for the avr-libc header when the game modules are compiled
+ * for the host. Each I/O register is an ordinary variable (defined in
+ * host/avr_io.c) so that code which pokes the hardware still compiles
+ * and runs, it just has no effect.
+ */
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+#define HOST_BUILD 1
+
+#define _BV(bit)				(1 << (bit))
+#define bit_is_set(sfr, bit)	((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit)	(!((sfr) & _BV(bit)))
+
+extern volatile uint8_t SREG;
+extern volatile uint8_t PORTA, PORTB, PORTC, PORTD;
+extern volatile uint8_t DDRA, DDRB, DDRC, DDRD;
+extern volatile uint8_t PINA, PINB, PINC, PIND;
+extern volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, TIMSK0, TIFR0;
+extern volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TIFR1;
+extern volatile uint16_t TCNT1, OCR1A;
+extern volatile uint8_t GTCCR;
+extern volatile uint8_t PCICR, PCIFR, PCMSK1;
+extern volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UDR0;
+extern volatile uint16_t UBRR0;
+extern volatile uint8_t SPCR0, SPSR0, SPDR0;
+
+/* Status register */
+#define SREG_I		7
+
+/* Timer 0 */
+#define CS00		0
+#define CS01		1
+#define CS02		2
+#define WGM01		1
+#define OCIE0A		1
+#define OCF0A		1
+
+/* Timer 1 */
+#define CS10		0
+#define WGM12		3
+#define OCIE1A		1
+#define OCF1A		1
+
+/* General timer control */
+#define PSRSYNC		0
+#define TSM			7
+
+/* Pin change interrupts */
+#define PCIE1		1
+#define PCIF1		1
+#define PCINT8		0
+#define PCINT9		1
+#define PCINT10		2
+#define PCINT11		3
+
+/* USART 0 */
+#define RXC0		7
+#define TXC0		6
+#define UDRE0		5
+#define DOR0		3
+#define U2X0		1
+#define RXCIE0		7
+#define UDRIE0		5
+#define RXEN0		4
+#define TXEN0		3
+
+/* SPI */
+#define SPE0		6
+#define MSTR0		4
+#define SPR10		1
+#define SPR00		0
+#define SPIF0		7
+#define SPI2X0		0
+
+/* Host stand-in for the avr-libc stdio stream set-up macro. The
+ * resulting stream is never used on the host.
+ */
+#define FDEV_SETUP_STREAM(put, get, rwflag)	{ 0 }
+#define _FDEV_SETUP_RW	0
+
+#endif /* HOST_AVR_IO_H_ */
@@ -0,0 +1,29 @@
+/*
+ * avr/pgmspace.h (host shim)
+ *
+ * The host has a single address space so program memory data is
+ * just ordinary const data.
+ */
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <avr/io.h>
+
+#define PROGMEM
+#define PSTR(s)					(s)
+#define pgm_read_byte(addr)		(*(const uint8_t*)(addr))
+#define pgm_read_word(addr)		(*(const uint16_t*)(addr))
+#define pgm_read_ptr(addr)		(*(const void* const*)(addr))
+#define memcpy_P				memcpy
+#define strlen_P				strlen
+#define fputs_P					fputs
+#define printf_P				printf
+#define sprintf_P				sprintf
+#define snprintf_P				snprintf
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
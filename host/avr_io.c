@@ -0,0 +1,20 @@
+/*
+ * avr_io.c (host build)
+ *
+ * Storage for the simulated I/O registers declared in host/avr/io.h
+ */
+
+#include <avr/io.h>
+
+volatile uint8_t SREG;
+volatile uint8_t PORTA, PORTB, PORTC, PORTD;
+volatile uint8_t DDRA, DDRB, DDRC, DDRD;
+volatile uint8_t PINA, PINB, PINC, PIND;
+volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, TIMSK0, TIFR0;
+volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TIFR1;
+volatile uint16_t TCNT1, OCR1A;
+volatile uint8_t GTCCR;
+volatile uint8_t PCICR, PCIFR, PCMSK1;
+volatile uint8_t UCSR0A, UCSR0B, UCSR0C, UDR0;
+volatile uint16_t UBRR0;
+volatile uint8_t SPCR0, SPSR0, SPDR0;
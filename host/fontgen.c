@@ -0,0 +1,186 @@
+/*
+ * fontgen.c (host build)
+ *
+ * Generates font.h - the font used by scrolling_char_display.c - from
+ * the font definition in font.txt (see that file for the format).
+ *
+ * The generated font is two program memory arrays:
+ * - font_atlas: the columns of every glyph, one after the other, one 
+ *   byte per column (bit 7 to bit 1 are rows 7 to 1, bit 0 is unused)
+ * - font_offsets: for each character from FONT_FIRST_CHAR to 
+ *   FONT_LAST_CHAR, the index in font_atlas of its first column. There
+ *   is one extra entry at the end so that the width of character c is 
+ *   always font_offsets[c+1] - font_offsets[c] (0 if it has no glyph).
+ * so finding a character's columns is two table lookups.
+ *
+ * font.h is kept in the repository so the AVR build doesn't need this
+ * program. After changing font.txt, regenerate it (from the top level
+ * directory) with
+ *     gcc -std=gnu99 -Wall -o fontgen host/fontgen.c
+ *     ./fontgen host/font.txt > font.h
+ * The program memory used by the font is reported on standard error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define FIRST_CHAR	' '
+#define LAST_CHAR	'Z'
+#define NUM_CHARS	(LAST_CHAR - FIRST_CHAR + 1)
+
+// Rows 7 to 1 of the LED matrix
+#define GLYPH_HEIGHT 7
+
+// Must match SCROLL_COLUMNS_PER_CHAR in scrolling_char_display.h (which
+// allows for a blank column before each character)
+#define MAX_WIDTH 5
+
+// Offsets are stored as bytes
+#define MAX_ATLAS_SIZE 255
+
+static uint8_t glyph_columns[NUM_CHARS][MAX_WIDTH];
+static uint8_t glyph_width[NUM_CHARS];
+static uint8_t glyph_defined[NUM_CHARS];
+
+static const char* filename;
+static int line_number;
+
+static void error(const char* message) {
+	fprintf(stderr, "%s:%d: %s\n", filename, line_number, message);
+	exit(1);
+}
+
+// Read the next line that isn't blank or a comment, without the line
+// ending. Returns 0 at the end of the file. A line that doesn't fit in
+// the buffer (size - 2 characters at most) is an error.
+static int read_line(FILE* f, char* line, int size) {
+	while(fgets(line, size, f)) {
+		line_number++;
+		if(!strchr(line, '\n') && !feof(f)) {
+			error("line is too long");
+		}
+		line[strcspn(line, "\r\n")] = 0;
+		if(line[0] && strncmp(line, "//", 2) != 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void read_glyph(FILE* f, int c) {
+	char line[80];
+	int width = -1;
+
+	if(glyph_defined[c - FIRST_CHAR]) {
+		error("character defined more than once");
+	}
+	for(int row = 7; row >= 1; row--) {
+		if(!read_line(f, line, sizeof(line))) {
+			error("expected 7 rows");
+		}
+		if(width < 0) {
+			width = strlen(line);
+			if(width > MAX_WIDTH) {
+				error("glyph is too wide");
+			}
+		} else if((int)strlen(line) != width) {
+			error("rows must all be the same width");
+		}
+		for(int x = 0; x < width; x++) {
+			if(line[x] == '#') {
+				glyph_columns[c - FIRST_CHAR][x] |= 1 << row;
+			} else if(line[x] != '.') {
+				error("expected # or .");
+			}
+		}
+	}
+	glyph_width[c - FIRST_CHAR] = width;
+	glyph_defined[c - FIRST_CHAR] = 1;
+}
+
+int main(int argc, char* argv[]) {
+	FILE* f;
+	char line[80];
+	int c;
+	int atlas_size = 0;
+	int offset;
+
+	if(argc != 2) {
+		fprintf(stderr, "Usage: %s font.txt > font.h\n", argv[0]);
+		return 1;
+	}
+	filename = argv[1];
+	f = fopen(filename, "r");
+	if(!f) {
+		perror(filename);
+		return 1;
+	}
+	while(read_line(f, line, sizeof(line))) {
+		if(strcmp(line, "= space") == 0) {
+			c = ' ';
+		} else if(strlen(line) == 3 && line[0] == '=' && line[1] == ' ') {
+			c = line[2];
+		} else {
+			error("expected \"= c\"");
+		}
+		if(c < FIRST_CHAR || c > LAST_CHAR) {
+			error("character out of range");
+		}
+		read_glyph(f, c);
+	}
+	fclose(f);
+
+	for(c = 0; c < NUM_CHARS; c++) {
+		atlas_size += glyph_width[c];
+	}
+	if(atlas_size > MAX_ATLAS_SIZE) {
+		fprintf(stderr, "%s: font is too big (%d columns)\n", filename, atlas_size);
+		return 1;
+	}
+
+	printf("/*\n");
+	printf(" * font.h\n");
+	printf(" *\n");
+	printf(" * GENERATED FILE - DO NOT EDIT. This is produced from host/font.txt\n");
+	printf(" * by host/fontgen.c, which describes the layout.\n");
+	printf(" *\n");
+	printf(" * Only to be included by scrolling_char_display.c.\n");
+	printf(" */\n\n");
+	printf("#ifndef FONT_H_\n");
+	printf("#define FONT_H_\n\n");
+	printf("#include <stdint.h>\n");
+	printf("#include <avr/pgmspace.h>\n\n");
+	printf("#define FONT_FIRST_CHAR %d\n", FIRST_CHAR);
+	printf("#define FONT_LAST_CHAR %d\n\n", LAST_CHAR);
+
+	printf("static const uint8_t font_atlas[%d] PROGMEM = {", atlas_size);
+	offset = 0;
+	for(c = 0; c < NUM_CHARS; c++) {
+		if(!glyph_width[c]) {
+			continue;
+		}
+		printf("%s\n\t\t/* %c */ ", offset ? "," : "", c + FIRST_CHAR);
+		for(int x = 0; x < glyph_width[c]; x++) {
+			printf("%s0x%02X", x ? ", " : "", glyph_columns[c][x]);
+		}
+		offset += glyph_width[c];
+	}
+	printf(" };\n\n");
+
+	printf("static const uint8_t font_offsets[%d] PROGMEM = {", NUM_CHARS + 1);
+	offset = 0;
+	for(c = 0; c <= NUM_CHARS; c++) {
+		printf("%s%s%3d", c ? "," : "", (c % 12) ? " " : "\n\t\t", offset);
+		if(c < NUM_CHARS) {
+			offset += glyph_width[c];
+		}
+	}
+	printf(" };\n\n");
+	printf("#endif /* FONT_H_ */\n");
+
+	fprintf(stderr, "font: %d bytes of glyph columns + %d bytes of offsets = %d bytes\n",
+			atlas_size, NUM_CHARS + 1, atlas_size + NUM_CHARS + 1);
+	return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * frame.c (host build)
+ *
+ * Reading binary frames out of a serial log - see frame.h. The frame
+ * layout is described in serial_write_frame() in serialio.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "frame.h"
+#include "serialio.h"
+
+int frame_next(const uint8_t* log, size_t log_length, size_t* pos, Frame* frame) {
+	size_t i;
+	uint16_t length;
+	uint8_t checksum;
+
+	for(i = *pos; i + 5 <= log_length; i++) {
+		if(log[i] != SERIAL_FRAME_START) {
+			continue;
+		}
+		length = log[i+2] | (log[i+3] << 8);
+		if(i + 5 + length > log_length) {
+			continue;
+		}
+		// All bytes after the start byte (including the checksum) 
+		// should add up to 0
+		checksum = 0;
+		for(size_t j = i + 1; j < i + 5 + length; j++) {
+			checksum += log[j];
+		}
+		if(checksum != 0) {
+			continue;
+		}
+		frame->type = log[i+1];
+		frame->length = length;
+		frame->data = &log[i+4];
+		*pos = i + 5 + length;
+		return 1;
+	}
+	*pos = log_length;
+	return 0;
+}
+
+int frame_find_last(const uint8_t* log, size_t log_length, uint8_t type,
+		Frame* frame) {
+	size_t pos = 0;
+	Frame candidate;
+	int found = 0;
+
+	while(frame_next(log, log_length, &pos, &candidate)) {
+		if(candidate.type == type) {
+			*frame = candidate;
+			found = 1;
+		}
+	}
+	return found;
+}
+
+void frame_write(FILE* file, uint8_t type, const uint8_t* data, uint16_t length) {
+	uint8_t checksum = type + (length & 0xFF) + (length >> 8);
+
+	fputc(SERIAL_FRAME_START, file);
+	fputc(type, file);
+	fputc(length & 0xFF, file);
+	fputc(length >> 8, file);
+	for(uint16_t i = 0; i < length; i++) {
+		fputc(data[i], file);
+		checksum += data[i];
+	}
+	fputc((uint8_t)-checksum, file);
+}
+
+uint8_t* read_file(const char* filename, size_t* length) {
+	FILE* file;
+	uint8_t* data = NULL;
+	size_t allocated = 0;
+	size_t got;
+
+	file = fopen(filename, "rb");
+	if(!file) {
+		perror(filename);
+		return NULL;
+	}
+	*length = 0;
+	do {
+		if(*length == allocated) {
+			allocated = allocated ? allocated * 2 : 4096;
+			data = realloc(data, allocated);
+			if(!data) {
+				fprintf(stderr, "%s: out of memory\n", filename);
+				fclose(file);
+				return NULL;
+			}
+		}
+		got = fread(data + *length, 1, allocated - *length, file);
+		*length += got;
+	} while(got > 0);
+	fclose(file);
+	return data;
+}
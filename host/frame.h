@@ -0,0 +1,39 @@
+/*
+ * frame.h (host build)
+ *
+ * Reading the binary frames written by serial_write_frame() (see 
+ * serialio.h) out of a log of the board's serial output.
+ */
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+	uint8_t type;
+	uint16_t length;
+	const uint8_t* data;
+} Frame;
+
+// Find the next valid frame in the log at or after position *pos. If one
+// is found it is returned in *frame, *pos is moved past it and 1 is 
+// returned. Otherwise 0 is returned. (Bytes which aren't part of a valid
+// frame - e.g. terminal output - are skipped.)
+int frame_next(const uint8_t* log, size_t log_length, size_t* pos, Frame* frame);
+
+// Find the last frame of the given type in the log. Returns 1 if found.
+int frame_find_last(const uint8_t* log, size_t log_length, uint8_t type,
+		Frame* frame);
+
+// Write a frame in the same layout as serial_write_frame(), so that host
+// tools can produce files that look like a log of the board's output
+void frame_write(FILE* file, uint8_t type, const uint8_t* data, uint16_t length);
+
+// Read a whole file into memory (which the caller must free). Returns 
+// NULL (after printing a message) if the file can't be read.
+uint8_t* read_file(const char* filename, size_t* length);
+
+#endif /* FRAME_H_ */
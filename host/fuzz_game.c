@@ -0,0 +1,313 @@
+/*
+ * fuzz_game.c (host build)
+ *
+ * Fuzz harness for the game logic in game.c. Each input is a sequence of
+ * bytes that drives the game directly - the first two bytes seed the
+ * random number generator and each byte after that is one call:
+ *     byte & 7 == 0    move_base(MOVE_LEFT)
+ *                 1    move_base(MOVE_RIGHT)
+ *                 2    fire_projectile()
+ *                 3    advance_projectiles()
+ *                 4    advance_falling_astroid()
+ *                 5-7  move the game clock on by (byte >> 3) * 10 ms and
+ *                      call advance_game() until nothing more is due
+ * After every call the game's invariants are checked:
+ *     - the base is on the field (0 to 7)
+ *     - there are at most MAX_PROJECTILES projectiles, all of them on
+ *       the field (in projectiles[0] to projectiles[numProjectiles-1])
+ *       and no two in one cell
+ *     - there are MAX_ASTEROIDS asteroids, all of them on the field and
+ *       no two in one cell
+ *     - no more than 4 lives have been lost
+ *     - every LED matrix cell rendered is on the LED matrix
+ * If an invariant doesn't hold, the game state is printed and we abort()
+ * so that the fuzzer keeps the input. When the game ends a new one is
+ * started (with the same input carrying on).
+ *
+ * Build (from the top level directory), for libFuzzer:
+ *     clang -g -O1 -fsanitize=fuzzer,address -funsigned-char \
+ *         -DFUZZ_LIBFUZZER -Ihost -I. -o fuzz_game host/fuzz_game.c \
+ *         host/avr_io.c host/frame.c host/spi_host.c host/ledemu.c \
+ *         bitmap.c compositor.c display.c effects.c game.c ledmatrix.c \
+ *         prng.c render.c score.c serialio.c terminalio.c timer0.c
+ * or for AFL use afl-gcc (or afl-clang-fast) without -DFUZZ_LIBFUZZER and
+ * the sanitizer, or plain gcc to run inputs by hand.
+ *
+ * Usage (without libFuzzer):
+ *     fuzz_game [-r runs] [-l length] [-s seed] [input ...]
+ * Each input file is run in turn (standard input if there are none, as
+ * AFL expects). With -r, runs random inputs of the given length (default
+ * 4096 bytes) are generated and run instead, and the number of game ticks
+ * per minute is reported - an input that breaks an invariant is written
+ * to fuzz_game_failure.bin before we abort().
+ * Exit status is 0 if all of the invariants held, 2 if a file couldn't be
+ * read.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "compositor.h"
+#include "effects.h"
+#include "frame.h"
+#include "game.h"
+#include "ledmatrix.h"
+#include "prng.h"
+#include "render.h"
+#include "score.h"
+
+// Game state (from game.c)
+extern int8_t basePosition;
+extern int8_t numProjectiles;
+extern uint8_t projectiles[MAX_PROJECTILES];
+extern int8_t numAsteroids;
+extern uint8_t asteroids[MAX_ASTEROIDS];
+extern volatile uint32_t counter;
+
+// Game positions - see game.c
+#define GET_X_POSITION(posn)	((posn) >> 4)
+#define GET_Y_POSITION(posn)	((posn) & 0x0F)
+
+// Calls made and game moves (projectile or asteroid) - for -r
+static uint64_t total_calls;
+static uint64_t total_ticks;
+
+// The input being run and how far through it we are (for the failure
+// report)
+static const uint8_t* current_input;
+static size_t current_size;
+static size_t current_pos;
+static uint32_t game_time;
+
+static void print_positions(const char* name, const uint8_t* positions,
+		int8_t count) {
+	fprintf(stderr, "%s (%d):", name, count);
+	for(int8_t i = 0; i < count; i++) {
+		fprintf(stderr, " %d,%d", GET_X_POSITION(positions[i]),
+				GET_Y_POSITION(positions[i]));
+	}
+	fprintf(stderr, "\n");
+}
+
+static void fail(const char* invariant) {
+	FILE* file;
+
+	fprintf(stderr, "INVARIANT BROKEN: %s\n", invariant);
+	fprintf(stderr, "after byte %zu of %zu (0x%02X), game time %u ms\n",
+			current_pos, current_size, current_input[current_pos],
+			game_time);
+	fprintf(stderr, "base %d, lives lost %u\n", basePosition, counter);
+	print_positions("projectiles", projectiles,
+			numProjectiles <= MAX_PROJECTILES ? numProjectiles : MAX_PROJECTILES);
+	print_positions("asteroids", asteroids,
+			numAsteroids <= MAX_ASTEROIDS ? numAsteroids : MAX_ASTEROIDS);
+#ifndef FUZZ_LIBFUZZER
+	file = fopen("fuzz_game_failure.bin", "wb");
+	if(file) {
+		fwrite(current_input, 1, current_size, file);
+		fclose(file);
+	}
+#else
+	(void)file;
+#endif
+	abort();
+}
+
+// Returns 1 if there is a repeated position in the list
+static int repeated(const uint8_t* positions, int8_t count) {
+	for(int8_t i = 0; i < count; i++) {
+		for(int8_t j = i + 1; j < count; j++) {
+			if(positions[i] == positions[j]) {
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static void check_invariants(void) {
+	if(basePosition < 0 || basePosition >= FIELD_WIDTH) {
+		fail("base on the field");
+	}
+	if(numProjectiles < 0 || numProjectiles > MAX_PROJECTILES) {
+		fail("0 <= numProjectiles <= MAX_PROJECTILES");
+	}
+	for(int8_t i = 0; i < numProjectiles; i++) {
+		if(GET_X_POSITION(projectiles[i]) >= FIELD_WIDTH ||
+				GET_Y_POSITION(projectiles[i]) < 2) {
+			fail("projectiles on the field");
+		}
+	}
+	if(repeated(projectiles, numProjectiles)) {
+		fail("no two projectiles in one cell");
+	}
+	if(numAsteroids != MAX_ASTEROIDS) {
+		fail("numAsteroids == MAX_ASTEROIDS");
+	}
+	for(int8_t i = 0; i < numAsteroids; i++) {
+		if(GET_X_POSITION(asteroids[i]) >= FIELD_WIDTH) {
+			fail("asteroids on the field");
+		}
+	}
+	if(repeated(asteroids, numAsteroids)) {
+		fail("no two asteroids in one cell");
+	}
+	if(counter > 4) {
+		fail("no more than 4 lives lost");
+	}
+}
+
+// Render consumer - checks the cells and throws everything away
+static void check_render_command(const RenderCommand* command) {
+	if(command->type == RENDER_CELL &&
+			(command->cell.x >= MATRIX_NUM_COLUMNS ||
+			command->cell.y >= MATRIX_NUM_ROWS)) {
+		fail("rendered cells on the LED matrix");
+	}
+}
+
+static void start_game(void) {
+	initialise_game();
+	init_score();
+	start_game_clock();
+	game_time = 0;
+	check_invariants();
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+	uint8_t byte;
+
+	if(size < 2) {
+		return 0;
+	}
+	current_input = data;
+	current_size = size;
+	current_pos = 0;
+	render_set_consumer(check_render_command);
+	prng_seed(data[0] | (data[1] << 8));
+	start_game();
+
+	for(current_pos = 2; current_pos < size; current_pos++) {
+		byte = data[current_pos];
+		switch(byte & 7) {
+			case 0:
+				move_base(MOVE_LEFT);
+				break;
+			case 1:
+				move_base(MOVE_RIGHT);
+				break;
+			case 2:
+				fire_projectile();
+				break;
+			case 3:
+				advance_projectiles();
+				total_ticks++;
+				break;
+			case 4:
+				advance_falling_astroid();
+				total_ticks++;
+				break;
+			default:
+				game_time += (byte >> 3) * 10;
+				while(advance_game(game_time)) {
+					total_ticks++;
+					check_invariants();
+				}
+				effects_update(game_time);
+				break;
+		}
+		total_calls++;
+		check_invariants();
+		compositor_flush();
+		render_drain();
+		if(is_game_over()) {
+			start_game();
+		}
+	}
+	return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+// xorshift32 - for generating random inputs with -r
+static uint32_t random_state;
+
+static uint32_t next_random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+int main(int argc, char* argv[]) {
+	long runs = 0;
+	size_t length = 4096;
+	int option;
+	uint8_t* input;
+	size_t size;
+	clock_t start;
+	double seconds;
+
+	random_state = time(NULL);
+	while((option = getopt(argc, argv, "r:l:s:")) != -1) {
+		if(option == 'r') {
+			runs = atol(optarg);
+		} else if(option == 'l') {
+			length = atol(optarg);
+		} else if(option == 's') {
+			random_state = strtoul(optarg, NULL, 0);
+		} else {
+			fprintf(stderr, "Usage: %s [-r runs] [-l length] [-s seed] "
+					"[input ...]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(random_state == 0) {
+		random_state = 1;
+	}
+
+	if(runs) {
+		input = malloc(length);
+		start = clock();
+		for(long run = 0; run < runs; run++) {
+			for(size_t i = 0; i < length; i++) {
+				input[i] = next_random();
+			}
+			LLVMFuzzerTestOneInput(input, length);
+		}
+		seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+		printf("%ld inputs, %llu calls, %llu ticks in %.2f s - "
+				"%.1f million ticks per minute\n", runs,
+				(unsigned long long)total_calls,
+				(unsigned long long)total_ticks, seconds,
+				total_ticks / seconds * 60 / 1e6);
+		free(input);
+	} else if(optind == argc) {
+		// Read standard input
+		size = 0;
+		input = NULL;
+		do {
+			input = realloc(input, size + 4096);
+			length = fread(input + size, 1, 4096, stdin);
+			size += length;
+		} while(length);
+		LLVMFuzzerTestOneInput(input, size);
+		free(input);
+	} else {
+		for(int i = optind; i < argc; i++) {
+			input = read_file(argv[i], &size);
+			if(!input) {
+				return 2;
+			}
+			LLVMFuzzerTestOneInput(input, size);
+			free(input);
+		}
+	}
+	printf("all invariants held\n");
+	return 0;
+}
+
+#endif
@@ -0,0 +1,337 @@
+/*
+ * fuzz_serial.c (host build)
+ *
+ * Fuzz harness for serial input - the receive interrupt handler and
+ * input buffer in serialio.c, uart_get_char() and the escape sequence
+ * decoder (decode_terminal_input() in terminalio.c). serialio.c is
+ * included here so that its buffers and interrupt handlers can be used
+ * directly. Characters are received, read, transmitted and thrown away
+ * in whatever order the input says and the results are checked against
+ * a simple model:
+ *     - every character received is read back in order (with \r turned
+ *       into \n) unless the input buffer was full, in which case it is
+ *       counted as an overrun - the overrun count must be exact
+ *     - the input buffer's position and count are always in range
+ *     - if echo is on, every character that fit in the output buffer is
+ *       transmitted in order (with \r added before \n)
+ *     - each character read is decoded as a cursor key if and only if it
+ *       came straight after ESC [ (and isn't ESC), and as nothing if and
+ *       only if it is ESC or is a [ straight after ESC - otherwise it is
+ *       passed through unchanged
+ * If anything doesn't match we abort() so that the fuzzer keeps the input.
+ *
+ * The first byte of an input turns echo on (bit 0 set) or off. After
+ * that, input is taken two bytes at a time - an operation and a value:
+ *     operation & 3 == 0   receive the value ((operation >> 2) + 1 times)
+ *                      1   read a character (if one is waiting) and
+ *                          decode it ((operation >> 2) + 1 times)
+ *                      2   transmit a character from the output buffer
+ *                          ((operation >> 2) + 1 times)
+ *                      3   clear_serial_input_buffer() (and forget any
+ *                          partly received escape sequence)
+ *
+ * Build (from the top level directory), for libFuzzer:
+ *     clang -g -O1 -fsanitize=fuzzer,address -funsigned-char \
+ *         -DFUZZ_LIBFUZZER -Ihost -I. -o fuzz_serial host/fuzz_serial.c \
+ *         host/avr_io.c host/frame.c terminalio.c
+ * or for AFL use afl-gcc (or afl-clang-fast) without -DFUZZ_LIBFUZZER and
+ * the sanitizer, or plain gcc to run inputs by hand.
+ *
+ * Usage (without libFuzzer):
+ *     fuzz_serial [-r runs] [-l length] [-s seed] [input ...]
+ * As for fuzz_game.c - with -r, random inputs are generated and run and
+ * the number of characters received (and read and decoded) per second
+ * is reported. A failing input is written to fuzz_serial_failure.bin.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "terminalio.h"
+
+#include "../serialio.c"
+
+// Model of the input and output buffers - characters waiting to be read
+// (or transmitted) and the number of overruns. The output buffer can't
+// hold more than OUTPUT_BUFFER_SIZE characters so that's all we need.
+static char expected_input[INPUT_BUFFER_SIZE];
+static uint8_t expected_input_count;
+static uint16_t expected_overruns;
+static char expected_output[OUTPUT_BUFFER_SIZE];
+static uint16_t expected_output_count;
+
+// Escape sequence decoder state, and the last two characters read since
+// it was reset (0 if none)
+static uint8_t decoder_state;
+static char previous[2];
+
+// Totals for -r
+static uint64_t total_received;
+static uint64_t total_read;
+
+static const uint8_t* current_input;
+static size_t current_size;
+static size_t current_pos;
+
+static void fail(const char* what) {
+	FILE* file;
+
+	fprintf(stderr, "SERIAL INPUT CHECK FAILED: %s\n", what);
+	fprintf(stderr, "at byte %zu of %zu\n", current_pos, current_size);
+	fprintf(stderr, "input buffer: insert position %u, %u bytes, "
+			"%u overruns\n", input_insert_pos, bytes_in_input_buffer,
+			input_overruns);
+	fprintf(stderr, "model: %u bytes, %u overruns\n", expected_input_count,
+			expected_overruns);
+#ifndef FUZZ_LIBFUZZER
+	file = fopen("fuzz_serial_failure.bin", "wb");
+	if(file) {
+		fwrite(current_input, 1, current_size, file);
+		fclose(file);
+	}
+#else
+	(void)file;
+#endif
+	abort();
+}
+
+static void expect_output(char c) {
+	if(expected_output_count < OUTPUT_BUFFER_SIZE) {
+		expected_output[expected_output_count++] = c;
+	}
+}
+
+static void receive(uint8_t c) {
+	UDR0 = c;
+	USART0_RX_vect();
+	total_received++;
+
+	// The echo is only done if there's room for at least one character
+	// (each character put in the buffer separately after that)
+	if(do_echo && expected_output_count < OUTPUT_BUFFER_SIZE) {
+		if(c == '\n') {
+			expect_output('\r');
+		}
+		expect_output(c);
+	}
+	if(expected_input_count == INPUT_BUFFER_SIZE) {
+		if(expected_overruns != 0xFFFF) {
+			expected_overruns++;
+		}
+	} else {
+		expected_input[expected_input_count++] = (c == '\r') ? '\n' : c;
+	}
+}
+
+// What the decoder should return for character c
+static int16_t expected_decode(char c) {
+	if(c == ESCAPE_CHAR) {
+		return TERMINAL_INPUT_NONE;
+	}
+	if(previous[0] == ESCAPE_CHAR && previous[1] == '[') {
+		return TERMINAL_KEY(c);
+	}
+	if(previous[1] == ESCAPE_CHAR && c == '[') {
+		return TERMINAL_INPUT_NONE;
+	}
+	return (uint8_t)c;
+}
+
+static void read_and_decode(void) {
+	char c;
+	int16_t decoded;
+
+	if(serial_input_available() != (expected_input_count != 0)) {
+		fail("serial_input_available()");
+	}
+	if(!expected_input_count) {
+		return;
+	}
+	c = uart_get_char(NULL);
+	total_read++;
+	if(c != expected_input[0]) {
+		fail("character read is the next one received");
+	}
+	memmove(expected_input, expected_input + 1, --expected_input_count);
+
+	decoded = decode_terminal_input(&decoder_state, c);
+	if(decoded != expected_decode(c)) {
+		fail("decoded input");
+	}
+	previous[0] = previous[1];
+	previous[1] = c;
+}
+
+static void transmit(void) {
+	UCSR0B |= (1<<UDRIE0);
+	UDR0 = 0;
+	USART0_UDRE_vect();
+	if(expected_output_count == 0) {
+		if(UCSR0B & (1<<UDRIE0)) {
+			fail("transmit interrupt turned off when nothing to send");
+		}
+		return;
+	}
+	if(UDR0 != (uint8_t)expected_output[0]) {
+		fail("character transmitted is the next one echoed");
+	}
+	memmove(expected_output, expected_output + 1, --expected_output_count);
+}
+
+static void check_buffers(void) {
+	if(input_insert_pos >= INPUT_BUFFER_SIZE ||
+			bytes_in_input_buffer > INPUT_BUFFER_SIZE) {
+		fail("input buffer position and count in range");
+	}
+	if(bytes_in_input_buffer != expected_input_count) {
+		fail("input buffer count");
+	}
+	if(serial_input_overruns() != expected_overruns) {
+		fail("overrun count");
+	}
+	if(out_insert_pos >= OUTPUT_BUFFER_SIZE ||
+			bytes_in_out_buffer != expected_output_count) {
+		fail("output buffer position and count");
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+	uint8_t operation;
+	uint8_t repeat;
+
+	if(size < 1) {
+		return 0;
+	}
+	current_input = data;
+	current_size = size;
+	current_pos = 0;
+
+	// Start from scratch (as init_serial_stdio() does)
+	out_insert_pos = 0;
+	bytes_in_out_buffer = 0;
+	input_insert_pos = 0;
+	bytes_in_input_buffer = 0;
+	input_overruns = 0;
+	do_echo = data[0] & 1;
+	expected_input_count = 0;
+	expected_overruns = 0;
+	expected_output_count = 0;
+	decoder_state = 0;
+	previous[0] = previous[1] = 0;
+
+	for(current_pos = 1; current_pos + 1 < size; current_pos += 2) {
+		operation = data[current_pos];
+		repeat = (operation >> 2) + 1;
+		switch(operation & 3) {
+			case 0:
+				while(repeat--) {
+					receive(data[current_pos + 1]);
+				}
+				break;
+			case 1:
+				while(repeat--) {
+					read_and_decode();
+				}
+				break;
+			case 2:
+				while(repeat--) {
+					transmit();
+				}
+				break;
+			case 3:
+				clear_serial_input_buffer();
+				expected_input_count = 0;
+				decoder_state = 0;
+				previous[0] = previous[1] = 0;
+				break;
+		}
+		check_buffers();
+	}
+	return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+// xorshift32 - for generating random inputs with -r
+static uint32_t random_state;
+
+static uint32_t next_random(void) {
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+int main(int argc, char* argv[]) {
+	long runs = 0;
+	size_t length = 4096;
+	int option;
+	uint8_t* input;
+	size_t size;
+	clock_t start;
+	double seconds;
+
+	random_state = time(NULL);
+	while((option = getopt(argc, argv, "r:l:s:")) != -1) {
+		if(option == 'r') {
+			runs = atol(optarg);
+		} else if(option == 'l') {
+			length = atol(optarg);
+		} else if(option == 's') {
+			random_state = strtoul(optarg, NULL, 0);
+		} else {
+			fprintf(stderr, "Usage: %s [-r runs] [-l length] [-s seed] "
+					"[input ...]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(random_state == 0) {
+		random_state = 1;
+	}
+
+	if(runs) {
+		input = malloc(length);
+		start = clock();
+		for(long run = 0; run < runs; run++) {
+			for(size_t i = 0; i < length; i++) {
+				input[i] = next_random();
+			}
+			LLVMFuzzerTestOneInput(input, length);
+		}
+		seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+		printf("%ld inputs, %llu characters received, %llu read and "
+				"decoded in %.2f s - %.1f million characters per second\n",
+				runs, (unsigned long long)total_received,
+				(unsigned long long)total_read, seconds,
+				total_received / seconds / 1e6);
+		free(input);
+	} else if(optind == argc) {
+		// Read standard input
+		size = 0;
+		input = NULL;
+		do {
+			input = realloc(input, size + 4096);
+			length = fread(input + size, 1, 4096, stdin);
+			size += length;
+		} while(length);
+		LLVMFuzzerTestOneInput(input, size);
+		free(input);
+	} else {
+		for(int i = optind; i < argc; i++) {
+			input = read_file(argv[i], &size);
+			if(!input) {
+				return 2;
+			}
+			LLVMFuzzerTestOneInput(input, size);
+			free(input);
+		}
+	}
+	printf("all checks passed\n");
+	return 0;
+}
+
+#endif
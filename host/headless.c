@@ -0,0 +1,693 @@
+/*
+ * headless.c (host build)
+ *
+ * Runs the game on the host (PC) with no hardware. The game modules are
+ * compiled unchanged against the stand-in avr-libc headers in this
+ * directory; spi.c is replaced by spi_host.c.
+ *
+ * A recording made on the board (see replay.h) is replayed as fast as
+ * possible and we report whether the game ended the same way it did on
+ * the board. This can be used for regression testing (a recording should
+ * still replay exactly after a change to code that shouldn't affect the
+ * game) and for performance comparisons (e.g. bytes sent to the LED
+ * matrix, or time taken, for the same game).
+ *
+ * The bytes sent to the LED matrix go to an emulated LED matrix (see
+ * ledemu.h). Each time around the game loop that sent anything to it is
+ * a frame - frames can be written out as text and checked against the
+ * frames from an earlier run (golden frames), so a change that should 
+ * only affect how things are sent can be checked to still show exactly
+ * the same thing.
+ *
+ * The game's terminal output goes through a stand-in for the serial port
+ * (which adds a carriage return before each newline, as uart_put_char()
+ * does) to an emulated terminal (see vtemu.h). Each time around the game
+ * loop that sent anything to the terminal is a tick, and the screen can be
+ * written out and checked against golden screens in the same way as LED
+ * matrix frames.
+ *
+ * Build (from the top level directory):
+ *     gcc -std=gnu99 -O2 -funsigned-char -Ihost -I. -o headless \
+ *         host/headless.c host/avr_io.c host/spi_host.c host/frame.c \
+ *         host/ledemu.c host/vtemu.c \
+ *         autopilot.c bitmap.c buttons.c compositor.c display.c effects.c \
+ *         game.c isrstats.c ledmatrix.c prng.c render.c replay.c score.c \
+ *         highspeed.c scrolling_char_display.c serialio.c terminalio.c \
+ *         tickstats.c timer0.c
+ *
+ * Usage:
+ *     headless [-v] [-n] [-F frames] [-g golden] [-T screens] [-G golden]
+ *              [-P image.ppm] [-S spi_trace] serial_log
+ *     headless -a games [-t] [-H] [-R recording] [-v] [-n] [-F frames] ...
+ * serial_log is a capture of the board's serial output for a whole game.
+ * The parts of the game's recording in it (see replay.h - the last part 
+ * is sent by pressing 'd' at the game over screen) are joined back 
+ * together - if a part is missing there's nothing to replay. The last
+ * recording in the log is used. The game's terminal output is also
+ * copied to our standard output if -v is given. With -n the game drives
+ * only the null display backend (see display.h), so the time reported is
+ * for the game logic alone (and there are no LED matrix frames).
+ * -F writes every LED matrix frame to the given file as text (see 
+ * ledemu_write_text()), each after a line giving the frame number, the
+ * game time of the latest move and the number of bytes the frame took.
+ * -g checks the frames against a file written by -F. -T and -G do the
+ * same for the terminal screen (see vtemu_write_text()) at the end of 
+ * each tick, with a line giving the tick number, game time and number of
+ * bytes sent to the terminal in the tick. -P writes the final frame as a
+ * PPM image. -S writes the LED matrix SPI bytes to the given file as a
+ * SERIAL_FRAME_SPI_CAPTURE frame (as spi_capture_dump() does on the 
+ * board - see spi.h), with the game time of the latest move as the time
+ * of each byte, for host/spitrace.c.
+ * With -a there is no serial_log - instead the autopilot (see autopilot.h)
+ * plays the given number of games at maximum speed (or in real time with
+ * -t) for soak testing, in high speed mode (see highspeed.h) with -H.
+ * Each game is replayed straight after it is played to check that it
+ * replays the same way. The autopilot's best and average scores are
+ * reported along with everything else. The parts of each recording are
+ * taken from the frames the game sends through the stand-in UART, as
+ * they would be from the board's serial output. -R writes them out for
+ * the longest game, as a serial_log that can be replayed later.
+ * Exit status is 0 if the replay matched the recording (and the golden
+ * frames and screens, if given), 1 if it didn't (or the recording was
+ * incomplete) and 2 if a file couldn't be read or written. With -a it is
+ * 1 if any of the replays didn't match.
+ * host/reference/check.sh runs the reference recordings and golden files
+ * kept in that directory.
+ */
+
+// For fopencookie()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "frame.h"
+#include "ledemu.h"
+#include "vtemu.h"
+#include "spi_host.h"
+#include "spi.h"
+
+// Bring in the game's main loop (play_game() etc.) from project.c. Its
+// main() is renamed so that it doesn't clash with ours.
+#define main project_main
+#include "../project.c"
+#undef main
+
+// Timer 0 interrupt handler (timer0.c) - see run_clock() - and UART
+// data register empty handler (serialio.c) - see uart_drain()
+void TIMER0_COMPA_vect(void);
+void USART0_UDRE_vect(void);
+
+// Snapshots (LED matrix frames or terminal screens) written to a file
+// and/or checked against golden snapshots - the golden file contents, how 
+// far through it we've checked and the first snapshot that didn't match
+// (0 if none)
+typedef struct {
+	FILE* file;
+	uint8_t* golden;
+	size_t golden_length;
+	size_t golden_pos;
+	uint32_t mismatch;
+} Snapshots;
+
+static Snapshots led_frames;
+static Snapshots terminal_screens;
+
+// LED matrix frames. frame_bytes_start is the number of bytes the LED
+// matrix had received at the start of the current frame.
+static uint32_t frame_count;
+static uint32_t frame_bytes_start;
+static uint32_t frame_bytes_max;
+
+// Emulated terminal, and ticks in which the game sent anything to it
+static VtEmulator terminal;
+static FILE* terminal_copy;
+static uint32_t tick_count;
+static uint32_t tick_bytes_start;
+static uint32_t tick_bytes_max;
+
+// Add a snapshot (number is the frame or tick number, from 1)
+static void add_snapshot(Snapshots* snapshots, const char* text, 
+		size_t length, uint32_t number) {
+	if(snapshots->file) {
+		fwrite(text, 1, length, snapshots->file);
+	}
+	if(snapshots->golden && !snapshots->mismatch) {
+		if(snapshots->golden_pos + length > snapshots->golden_length ||
+				memcmp(&snapshots->golden[snapshots->golden_pos], text, 
+				length) != 0) {
+			snapshots->mismatch = number;
+		}
+		snapshots->golden_pos += length;
+	}
+}
+
+// Called at the end of all snapshots - count = number of snapshots taken
+static void finish_snapshots(Snapshots* snapshots, uint32_t count) {
+	if(snapshots->golden && !snapshots->mismatch &&
+			snapshots->golden_pos != snapshots->golden_length) {
+		// The golden file has more snapshots than we produced
+		snapshots->mismatch = count + 1;
+	}
+	if(snapshots->file) {
+		fclose(snapshots->file);
+	}
+}
+
+// Open the files for the -F/-T and -g/-G options. Returns 0 on failure.
+static int open_snapshots(Snapshots* snapshots, const char* filename,
+		const char* golden_filename) {
+	if(golden_filename) {
+		snapshots->golden = read_file(golden_filename, 
+				&snapshots->golden_length);
+		if(!snapshots->golden) {
+			return 0;
+		}
+	}
+	if(filename) {
+		snapshots->file = fopen(filename, "w");
+		if(!snapshots->file) {
+			perror(filename);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void led_frame_end(void) {
+	uint32_t bytes = spi_host_led.bytes - frame_bytes_start;
+	char* text;
+	size_t length;
+	FILE* stream;
+
+	if(bytes == 0) {
+		return;
+	}
+	frame_bytes_start = spi_host_led.bytes;
+	frame_count++;
+	if(bytes > frame_bytes_max) {
+		frame_bytes_max = bytes;
+	}
+	if(!led_frames.file && !led_frames.golden) {
+		return;
+	}
+
+	stream = open_memstream(&text, &length);
+	fprintf(stream, "frame %u time %lu bytes %u\n", frame_count,
+			(unsigned long)last_move_time(), bytes);
+	ledemu_write_text(&spi_host_led, stream);
+	fclose(stream);
+	add_snapshot(&led_frames, text, length, frame_count);
+	free(text);
+}
+
+static void terminal_tick_end(void) {
+	uint32_t bytes;
+	char* text;
+	size_t length;
+	FILE* stream;
+
+	fflush(stdout);
+	bytes = terminal.bytes - tick_bytes_start;
+	if(bytes == 0) {
+		return;
+	}
+	tick_bytes_start = terminal.bytes;
+	tick_count++;
+	if(bytes > tick_bytes_max) {
+		tick_bytes_max = bytes;
+	}
+	if(!terminal_screens.file && !terminal_screens.golden) {
+		return;
+	}
+
+	stream = open_memstream(&text, &length);
+	fprintf(stream, "tick %u time %lu bytes %u\n", tick_count,
+			(unsigned long)last_move_time(), bytes);
+	vtemu_write_text(&terminal, stream);
+	fclose(stream);
+	add_snapshot(&terminal_screens, text, length, tick_count);
+	free(text);
+}
+
+// Autopilot (-a) - the number of games to play, whether to play them in
+// real time (-t) and the wall clock time (ms) at which we started
+static long autopilot_games;
+static int real_time;
+static uint64_t wall_start;
+
+static uint64_t wall_clock_ms(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Stand-in for timer 0 - on the host the clock (get_current_time()) only
+// moves on when we call the timer interrupt handler. For the autopilot it
+// is moved on one millisecond each time around the game loop (so that each
+// game gets a different seed), or in step with the wall clock in real time.
+// A replay doesn't use the clock so it isn't needed.
+static void run_clock(void) {
+	uint64_t now;
+
+	if(!autopilot_games) {
+		return;
+	}
+	if(!real_time) {
+		TIMER0_COMPA_vect();
+		return;
+	}
+	if(terminal_copy) {
+		fflush(terminal_copy);
+	}
+	now = wall_clock_ms() - wall_start;
+	if(get_current_time() >= now) {
+		usleep(1000);
+		now = wall_clock_ms() - wall_start;
+	}
+	while(get_current_time() < now) {
+		TIMER0_COMPA_vect();
+	}
+}
+
+// Bytes sent through the UART (serialio.c's output buffer). The game's
+// standard output comes to serial_write() instead, so this is only the
+// frames sent with serial_write_frame() - e.g. the parts of a recording
+// (see replay.h).
+static FILE* uart_stream;
+static char* uart_log;
+static size_t uart_log_length;
+
+// Empty serialio.c's output buffer into uart_log, as the UART would
+static void uart_drain(void) {
+	while(UCSR0B & (1 << UDRIE0)) {
+		USART0_UDRE_vect();
+		if(UCSR0B & (1 << UDRIE0)) {
+			fputc(UDR0, uart_stream);
+		}
+	}
+	fflush(uart_stream);
+}
+
+// Start uart_log again
+static void uart_log_reset(void) {
+	if(uart_stream) {
+		fclose(uart_stream);
+		free(uart_log);
+	}
+	uart_stream = open_memstream(&uart_log, &uart_log_length);
+}
+
+// Join the parts of the last recording in a serial log back together
+// (see replay.h). A part sent more than once (e.g. 'd' pressed twice) is 
+// only used once. Returns the whole recording (which the caller must 
+// free) and the number of parts in *parts, or NULL if there is no whole
+// recording (e.g. a part is missing).
+static uint8_t* join_recording(const uint8_t* log, size_t log_length,
+		uint16_t* length, uint8_t* parts) {
+	uint8_t* recording = malloc(0x10000);
+	size_t pos = 0;
+	Frame frame;
+
+	*length = 0;
+	*parts = 0;
+	while(frame_next(log, log_length, &pos, &frame)) {
+		if(frame.type != SERIAL_FRAME_REPLAY || frame.length < 4 ||
+				frame.data[0] != REPLAY_VERSION) {
+			continue;
+		}
+		if(frame.data[3] == 0) {
+			// A new recording
+			memcpy(recording, frame.data, frame.length);
+			*length = frame.length;
+			*parts = 1;
+		} else if(*parts && memcmp(frame.data, recording, 3) == 0 &&
+				frame.data[3] == *parts - 1) {
+			// The last part again
+			continue;
+		} else if(*parts && memcmp(frame.data, recording, 3) == 0 &&
+				frame.data[3] == *parts && 
+				*length + frame.length - 4 <= 0xFFFF) {
+			memcpy(&recording[*length], &frame.data[4], frame.length - 4);
+			*length += frame.length - 4;
+			(*parts)++;
+		} else {
+			// Not the next part of the recording we have
+			*length = 0;
+			*parts = 0;
+		}
+	}
+	if(!*parts) {
+		free(recording);
+		return NULL;
+	}
+	return recording;
+}
+
+// Called at the end of each time around the game loop (as the end_frame
+// function of a display backend added after the others)
+static void frame_end(void) {
+	led_frame_end();
+	terminal_tick_end();
+	uart_drain();
+	run_clock();
+}
+
+// Serial port stand-in - the game's standard output is written here
+static void serial_byte(char c) {
+	vtemu_byte(&terminal, c);
+	if(terminal_copy) {
+		fputc(c, terminal_copy);
+	}
+}
+
+static ssize_t serial_write(void* cookie, const char* buffer, size_t size) {
+	for(size_t i = 0; i < size; i++) {
+		if(buffer[i] == '\n') {
+			serial_byte('\r');
+		}
+		serial_byte(buffer[i]);
+	}
+	return size;
+}
+
+static const DisplayBackend frame_backend = {
+	.end_frame = frame_end,
+};
+
+// SPI trace (-S) - laid out as the data of a SERIAL_FRAME_SPI_CAPTURE 
+// frame. If there are more bytes than fit in a frame, the latest are
+// kept.
+#define TRACE_HEADER_SIZE	5
+#define TRACE_ENTRY_SIZE	3
+#define TRACE_MAX_ENTRIES	((0xFFFF - TRACE_HEADER_SIZE) / TRACE_ENTRY_SIZE)
+static uint8_t trace[TRACE_HEADER_SIZE + TRACE_MAX_ENTRIES * TRACE_ENTRY_SIZE];
+static uint32_t trace_total;
+
+static void trace_byte(uint8_t byte) {
+	uint8_t* entry;
+	uint16_t now = last_move_time();
+
+	if(trace_total >= TRACE_MAX_ENTRIES) {
+		memmove(&trace[TRACE_HEADER_SIZE], 
+				&trace[TRACE_HEADER_SIZE + TRACE_ENTRY_SIZE],
+				(TRACE_MAX_ENTRIES - 1) * TRACE_ENTRY_SIZE);
+		entry = &trace[TRACE_HEADER_SIZE + 
+				(TRACE_MAX_ENTRIES - 1) * TRACE_ENTRY_SIZE];
+	} else {
+		entry = &trace[TRACE_HEADER_SIZE + trace_total * TRACE_ENTRY_SIZE];
+	}
+	entry[0] = byte;
+	entry[1] = now & 0xFF;
+	entry[2] = now >> 8;
+	trace_total++;
+}
+
+static int write_trace(const char* filename) {
+	FILE* file = fopen(filename, "wb");
+	uint32_t entries = trace_total;
+
+	if(!file) {
+		perror(filename);
+		return 0;
+	}
+	if(entries > TRACE_MAX_ENTRIES) {
+		entries = TRACE_MAX_ENTRIES;
+	}
+	trace[0] = SPI_CAPTURE_VERSION;
+	for(int i = 0; i < 4; i++) {
+		trace[1 + i] = (trace_total >> (8 * i)) & 0xFF;
+	}
+	frame_write(file, SERIAL_FRAME_SPI_CAPTURE, trace, 
+			TRACE_HEADER_SIZE + entries * TRACE_ENTRY_SIZE);
+	fclose(file);
+	return 1;
+}
+
+int main(int argc, char* argv[]) {
+	int verbose = 0;
+	int null_display = 0;
+	const char* frames_filename = NULL;
+	const char* golden_filename = NULL;
+	const char* screens_filename = NULL;
+	const char* golden_screens_filename = NULL;
+	const char* image_filename = NULL;
+	const char* trace_filename = NULL;
+	const char* recording_filename = NULL;
+	FILE* image;
+	FILE* recording_file;
+	int option;
+	const char* filename;
+	uint8_t* log = NULL;
+	size_t log_length;
+	uint8_t* recording = NULL;
+	uint16_t recording_length;
+	uint8_t recording_parts;
+	uint32_t longest_game = 0;
+	FILE* report;
+	int result;
+	clock_t start;
+	double seconds;
+	const AutopilotStats* stats;
+	uint32_t replays_matched = 0;
+	uint32_t replays_truncated = 0;
+	uint32_t replays_mismatched = 0;
+
+	while((option = getopt(argc, argv, "vnF:g:T:G:P:S:a:tHR:")) != -1) {
+		if(option == 'a') {
+			autopilot_games = atol(optarg);
+		} else if(option == 't') {
+			real_time = 1;
+		} else if(option == 'H') {
+			highspeed_choose(1);
+		} else if(option == 'R') {
+			recording_filename = optarg;
+		} else if(option == 'v') {
+			verbose = 1;
+		} else if(option == 'n') {
+			null_display = 1;
+		} else if(option == 'F') {
+			frames_filename = optarg;
+		} else if(option == 'g') {
+			golden_filename = optarg;
+		} else if(option == 'T') {
+			screens_filename = optarg;
+		} else if(option == 'G') {
+			golden_screens_filename = optarg;
+		} else if(option == 'P') {
+			image_filename = optarg;
+		} else if(option == 'S') {
+			trace_filename = optarg;
+			spi_host_observer = trace_byte;
+		} else {
+			optind = argc;
+			break;
+		}
+	}
+	if(optind != argc - (autopilot_games ? 0 : 1)) {
+		fprintf(stderr, "Usage: %s [-v] [-n] [-F frames] [-g golden] "
+				"[-T screens] [-G golden] [-P image.ppm] [-S spi_trace] "
+				"serial_log\n"
+				"       %s -a games [-t] [-H] [-R recording] [-v] [-n] [-F frames] "
+				"[-g golden] [-T screens] [-G golden] [-P image.ppm] "
+				"[-S spi_trace]\n",
+				argv[0], argv[0]);
+		return 2;
+	}
+
+	if(!autopilot_games) {
+		filename = argv[optind];
+		log = read_file(filename, &log_length);
+		if(!log) {
+			return 2;
+		}
+		recording = join_recording(log, log_length, &recording_length,
+				&recording_parts);
+		if(!recording || !replay_load(recording, recording_length)) {
+			fprintf(stderr, "%s: no whole recording found\n", filename);
+			return 2;
+		}
+	}
+	if(!open_snapshots(&led_frames, frames_filename, golden_filename) ||
+			!open_snapshots(&terminal_screens, screens_filename, 
+			golden_screens_filename)) {
+		return 2;
+	}
+
+	// Our report goes to the original standard output - the game's own
+	// output (terminal escape sequences) goes to the emulated terminal, 
+	// and is copied to the original standard output if -v was given
+	report = fdopen(dup(fileno(stdout)), "w");
+	if(verbose) {
+		terminal_copy = stdout;
+	}
+	vtemu_init(&terminal);
+	uart_log_reset();
+	stdout = fopencookie(NULL, "w", 
+			(cookie_io_functions_t){ .write = serial_write });
+	if(!stdout) {
+		perror("fopencookie");
+		return 2;
+	}
+
+	if(null_display) {
+		display_add_backend(&null_backend);
+	} else {
+		display_add_backend(&led_matrix_backend);
+		display_add_backend(&terminal_backend);
+	}
+	display_add_backend(&frame_backend);
+
+	start = clock();
+	if(autopilot_games) {
+		// Each game the autopilot plays is replayed straight away to check
+		// that it plays the same way again. (handle_game_over() isn't
+		// used - it waits for a button.)
+		autopilot_set_mode(real_time ? AUTOPILOT_REAL_TIME : 
+				AUTOPILOT_MAX_SPEED);
+		wall_start = wall_clock_ms();
+		for(long game = 0; game < autopilot_games; game++) {
+			uart_log_reset();
+			new_game();
+			play_game();
+			autopilot_game_over(get_score(), last_move_time());
+
+			// Send the last part of the recording (as 'd' does) and
+			// replay the parts that were sent
+			replay_dump();
+			uart_drain();
+			recording = join_recording((uint8_t*)uart_log, uart_log_length,
+					&recording_length, &recording_parts);
+			if(!recording || !replay_load(recording, recording_length)) {
+				replays_mismatched++;
+				free(recording);
+				continue;
+			}
+			if(recording_filename && last_move_time() >= longest_game) {
+				// Keep the longest game (as the serial log would have it)
+				longest_game = last_move_time();
+				recording_file = fopen(recording_filename, "wb");
+				if(!recording_file) {
+					perror(recording_filename);
+					return 2;
+				}
+				fwrite(uart_log, 1, uart_log_length, recording_file);
+				fclose(recording_file);
+			}
+			replay_start_playback();
+			new_game();
+			play_game();
+			free(recording);
+			recording = NULL;
+			if(replay_matched()) {
+				replays_matched++;
+			} else if(replay_end_code() == REPLAY_END_TRUNCATED) {
+				replays_truncated++;
+			} else {
+				replays_mismatched++;
+			}
+		}
+		result = replays_mismatched ? 1 : 0;
+	} else {
+		replay_start_playback();
+		new_game();
+		play_game();
+		result = replay_matched() ? 0 : 1;
+	}
+	fflush(stdout);
+	seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	finish_snapshots(&led_frames, frame_count);
+	finish_snapshots(&terminal_screens, tick_count);
+	if(led_frames.mismatch || terminal_screens.mismatch) {
+		result = 1;
+	}
+	if(image_filename) {
+		image = fopen(image_filename, "wb");
+		if(!image) {
+			perror(image_filename);
+			return 2;
+		}
+		ledemu_write_ppm(&spi_host_led, image, 16);
+		fclose(image);
+	}
+	if(trace_filename && !write_trace(trace_filename)) {
+		return 2;
+	}
+
+	if(autopilot_games) {
+		stats = autopilot_stats();
+		fprintf(report, "autopilot games: %u, best score %lu, average "
+				"score %.1f\n", stats->games, (unsigned long)stats->bestScore,
+				(double)stats->totalScore / stats->games);
+		fprintf(report, "longest game %lu ms, total game time %.1f s\n",
+				(unsigned long)stats->longestGame, stats->totalTime / 1000.0);
+		fprintf(report, "replays matched: %u, stopped (recording full): "
+				"%u, DID NOT MATCH: %u\n", replays_matched, 
+				replays_truncated, replays_mismatched);
+	} else {
+		fprintf(report, "seed %u, recording %u bytes in %u part%s\n", 
+				replay_seed(), recording_length, recording_parts,
+				recording_parts == 1 ? "" : "s");
+		fprintf(report, "game over at %lu ms, score %lu\n",
+				(unsigned long)last_move_time(), (unsigned long)get_score());
+	}
+	fprintf(report, "LED matrix bytes sent: %lu\n",
+			(unsigned long)spi_host_bytes_sent);
+	if(frame_count) {
+		fprintf(report, "LED matrix frames: %u, %.1f bytes per frame, "
+				"worst %u\n", frame_count,
+				(double)spi_host_led.bytes / frame_count, frame_bytes_max);
+	}
+	if(spi_host_led.errors) {
+		fprintf(report, "LED matrix bytes that weren't a valid command: %u\n",
+				spi_host_led.errors);
+	}
+	fprintf(report, "terminal bytes sent: %u\n", terminal.bytes);
+	if(tick_count) {
+		fprintf(report, "terminal ticks: %u, %.1f bytes per tick, "
+				"worst %u\n", tick_count,
+				(double)(tick_bytes_start) / tick_count, tick_bytes_max);
+	}
+	if(terminal.unknown) {
+		fprintf(report, "terminal sequences not understood: %u\n",
+				terminal.unknown);
+	}
+	if(led_frames.golden) {
+		if(led_frames.mismatch) {
+			fprintf(report, "GOLDEN FRAMES DIFFER from frame %u\n", 
+					led_frames.mismatch);
+		} else {
+			fprintf(report, "golden frames matched\n");
+		}
+	}
+	if(terminal_screens.golden) {
+		if(terminal_screens.mismatch) {
+			fprintf(report, "GOLDEN SCREENS DIFFER from tick %u\n", 
+					terminal_screens.mismatch);
+		} else {
+			fprintf(report, "golden screens matched\n");
+		}
+	}
+	fprintf(report, "host CPU time: %.3f ms%s\n", seconds * 1000,
+			null_display ? " (null display)" : "");
+	if(autopilot_games) {
+		fprintf(report, "%s\n", result == 0 ? "autopilot replays matched" :
+				"AUTOPILOT REPLAYS DID NOT MATCH");
+	} else {
+		fprintf(report, "%s\n", result == 0 ? "replay matched" :
+				(replay_end_code() == REPLAY_END_TRUNCATED ?
+				"replay stopped - recording was full" : 
+				"REPLAY DID NOT MATCH"));
+	}
+	fclose(report);
+	free(log);
+	free(recording);
+	free(led_frames.golden);
+	free(terminal_screens.golden);
+	return result;
+}
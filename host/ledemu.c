@@ -0,0 +1,171 @@
+/*
+ * ledemu.c (host build)
+ *
+ * LED matrix emulator - see ledemu.h
+ */
+
+#include <string.h>
+
+#include "ledemu.h"
+
+void ledemu_init(LedEmulator* led) {
+	memset(led, 0, sizeof(*led));
+}
+
+// Number of bytes (including the command byte) in the given command, or
+// 0 if it isn't a command
+static uint8_t command_length(uint8_t command) {
+	switch(command) {
+		case CMD_UPDATE_ALL:
+			return 1 + MATRIX_NUM_COLUMNS * MATRIX_NUM_ROWS;
+		case CMD_UPDATE_PIXEL:
+			return 3;
+		case CMD_UPDATE_ROW:
+			return 2 + MATRIX_NUM_COLUMNS;
+		case CMD_UPDATE_COL:
+			return 2 + MATRIX_NUM_ROWS;
+		case CMD_SHIFT_DISPLAY:
+			return 2;
+		case CMD_CLEAR_SCREEN:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+void ledemu_shift(MatrixData pixels, int dx, int dy) {
+	MatrixData shifted;
+	int from_x, from_y;
+
+	for(int x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		for(int y = 0; y < MATRIX_NUM_ROWS; y++) {
+			from_x = x - dx;
+			from_y = y - dy;
+			if(from_x >= 0 && from_x < MATRIX_NUM_COLUMNS &&
+					from_y >= 0 && from_y < MATRIX_NUM_ROWS) {
+				shifted[x][y] = pixels[from_x][from_y];
+			} else {
+				shifted[x][y] = COLOUR_BLACK;
+			}
+		}
+	}
+	memcpy(pixels, shifted, sizeof(shifted));
+}
+
+// Number of pixels that differ between two displays
+static uint32_t differences(MatrixData a, MatrixData b) {
+	uint32_t count = 0;
+
+	for(int x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		for(int y = 0; y < MATRIX_NUM_ROWS; y++) {
+			if(a[x][y] != b[x][y]) {
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+// Carry out the command that has just been received in full
+static void execute(LedEmulator* led) {
+	const uint8_t* args = led->args;
+	uint8_t x, y;
+	MatrixData before;
+
+	switch(led->command) {
+		case CMD_UPDATE_ALL:
+			for(y = 0; y < MATRIX_NUM_ROWS; y++) {
+				for(x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+					led->pixels[x][y] = *args++;
+				}
+			}
+			led->pixel_writes += MATRIX_NUM_COLUMNS * MATRIX_NUM_ROWS;
+			break;
+		case CMD_UPDATE_PIXEL:
+			led->pixels[args[0] & 0x0F][(args[0] >> 4) & 0x07] = args[1];
+			led->pixel_writes++;
+			break;
+		case CMD_UPDATE_ROW:
+			y = args[0] & 0x07;
+			for(x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+				led->pixels[x][y] = args[1 + x];
+			}
+			led->pixel_writes += MATRIX_NUM_COLUMNS;
+			break;
+		case CMD_UPDATE_COL:
+			x = args[0] & 0x0F;
+			for(y = 0; y < MATRIX_NUM_ROWS; y++) {
+				led->pixels[x][y] = args[1 + y];
+			}
+			led->pixel_writes += MATRIX_NUM_ROWS;
+			break;
+		case CMD_SHIFT_DISPLAY:
+			memcpy(before, led->pixels, sizeof(before));
+			ledemu_shift(led->pixels, 
+					((args[0] & SHIFT_RIGHT) ? 1 : 0) - ((args[0] & SHIFT_LEFT) ? 1 : 0),
+					((args[0] & SHIFT_UP) ? 1 : 0) - ((args[0] & SHIFT_DOWN) ? 1 : 0));
+			led->pixel_writes += differences(before, led->pixels);
+			break;
+		case CMD_CLEAR_SCREEN:
+			memcpy(before, led->pixels, sizeof(before));
+			memset(led->pixels, COLOUR_BLACK, sizeof(led->pixels));
+			led->pixel_writes += differences(before, led->pixels);
+			break;
+	}
+	led->commands++;
+}
+
+void ledemu_byte(LedEmulator* led, uint8_t byte) {
+	led->bytes++;
+	if(led->received == 0) {
+		led->needed = command_length(byte);
+		if(led->needed == 0) {
+			led->errors++;
+			return;
+		}
+		led->command = byte;
+	} else {
+		led->args[led->received - 1] = byte;
+	}
+	led->received++;
+	if(led->received == led->needed) {
+		execute(led);
+		led->received = 0;
+	}
+}
+
+void ledemu_write_text(const LedEmulator* led, FILE* file) {
+	PixelColour colour;
+
+	for(int y = MATRIX_NUM_ROWS - 1; y >= 0; y--) {
+		for(int x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			colour = led->pixels[x][y];
+			if(colour == COLOUR_BLACK) {
+				fputs("..", file);
+			} else {
+				fprintf(file, "%02X", colour);
+			}
+		}
+		fputc('\n', file);
+	}
+}
+
+void ledemu_write_ppm(const LedEmulator* led, FILE* file, int scale) {
+	PixelColour colour;
+
+	fprintf(file, "P6\n%d %d\n255\n", MATRIX_NUM_COLUMNS * scale,
+			MATRIX_NUM_ROWS * scale);
+	for(int y = MATRIX_NUM_ROWS - 1; y >= 0; y--) {
+		for(int row = 0; row < scale; row++) {
+			for(int x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+				// Green is the high 4 bits, red the low 4 bits
+				colour = led->pixels[x][y];
+				for(int column = 0; column < scale; column++) {
+					fputc((colour & 0x0F) * 17, file);
+					fputc((colour >> 4) * 17, file);
+					fputc(0, file);
+				}
+			}
+		}
+	}
+}
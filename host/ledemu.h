@@ -0,0 +1,59 @@
+/*
+ * ledemu.h (host build)
+ *
+ * LED matrix emulator. Takes the bytes sent to the LED matrix over SPI
+ * (the CMD_... commands in ledmatrix.h) one at a time, in exactly the
+ * form ledmatrix.c sends them, and keeps track of what the LED matrix
+ * would be showing. This lets the host build check what was actually
+ * displayed (e.g. against golden frames) and count the bytes it took.
+ */
+
+#ifndef LEDEMU_H_
+#define LEDEMU_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ledmatrix.h"
+
+typedef struct {
+	// What the LED matrix is showing
+	MatrixData pixels;
+
+	// The command being received (if any), how many bytes of it we've
+	// had and how many it needs (including the command byte)
+	uint8_t command;
+	uint8_t received;
+	uint8_t needed;
+	uint8_t args[1 + MATRIX_NUM_COLUMNS * MATRIX_NUM_ROWS];
+
+	// Totals - bytes received, complete commands carried out, bytes
+	// that weren't a valid command, and pixels written. Each pixel in an
+	// update counts as written (whether or not it changed), as does each
+	// pixel changed by a shift or a clear.
+	uint32_t bytes;
+	uint32_t commands;
+	uint32_t errors;
+	uint32_t pixel_writes;
+} LedEmulator;
+
+// Start with a clear display and nothing received
+void ledemu_init(LedEmulator* led);
+
+// Receive one SPI byte
+void ledemu_byte(LedEmulator* led, uint8_t byte);
+
+// Move every pixel dx columns and dy rows, as CMD_SHIFT_DISPLAY does. 
+// Pixels moved off the display are lost, pixels moved on are black.
+void ledemu_shift(MatrixData pixels, int dx, int dy);
+
+// Write what the display is showing as text - one line per row, top row
+// (y = 7) first, with each pixel as two hex digits (".." for black) so
+// that frames can be compared exactly
+void ledemu_write_text(const LedEmulator* led, FILE* file);
+
+// Write what the display is showing as a binary PPM image with each
+// LED scale pixels square
+void ledemu_write_ppm(const LedEmulator* led, FILE* file, int scale);
+
+#endif /* LEDEMU_H_ */
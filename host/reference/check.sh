@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# check.sh (host build)
+#
+# Replays the reference recordings in this directory with the host build
+# (see host/headless.c) and checks that each replays to the end of the
+# game, and that the game still shows exactly what it did when the golden
+# files were written. Run from the top level directory:
+#     sh host/reference/check.sh
+# Exit status is 0 if every check passed.
+#
+# long_game.log - a 72 second game (8 recording parts - see replay.h)
+#     played by the autopilot with the speed held from the start 
+#     (INPUT_HOLD_SPEED) so that it lasts. Made with
+#         headless -a 200 -n -R host/reference/long_game.log
+#     with autopilot_next_input() changed to hold the speed first.
+# game.log - a 7.6 second game played by the autopilot, made with
+#         headless -a 1 -R host/reference/game.log
+# game_frames.txt - its LED matrix frames (golden frames), written with
+#         headless -F host/reference/game_frames.txt host/reference/game.log
+# game_screens.txt - its terminal screens (golden screens), written with
+#         headless -T host/reference/game_screens.txt host/reference/game.log
+# A change that is meant to change what the game shows needs the golden
+# files to be written again (and the differences checked by hand).
+
+dir=host/reference
+headless=${TMPDIR:-/tmp}/headless.$$
+trap 'rm -f "$headless"' EXIT
+
+gcc -std=gnu99 -O2 -funsigned-char -Ihost -I. -o "$headless" \
+	host/headless.c host/avr_io.c host/spi_host.c host/frame.c \
+	host/ledemu.c host/vtemu.c \
+	autopilot.c bitmap.c buttons.c compositor.c display.c effects.c \
+	game.c isrstats.c ledmatrix.c prng.c render.c replay.c score.c \
+	highspeed.c scrolling_char_display.c serialio.c terminalio.c \
+	tickstats.c timer0.c || exit 1
+
+failed=0
+
+# check name headless_arguments... - runs headless and reports the result
+check() {
+	name=$1
+	shift
+	if "$headless" "$@" > "$headless.out"; then
+		echo "$name: passed"
+	else
+		echo "$name: FAILED"
+		cat "$headless.out"
+		failed=1
+	fi
+	rm -f "$headless.out"
+}
+
+check "long game replays to the end" -n $dir/long_game.log
+check "LED matrix frames match" -g $dir/game_frames.txt $dir/game.log
+check "terminal screens match" -G $dir/game_screens.txt $dir/game.log
+
+exit $failed
@@ -0,0 +1,30 @@
+/*
+ * spi_host.c (host build)
+ *
+ * Replacement for spi.c in the host build. There is no LED matrix, so
+ * bytes sent are counted and passed to an emulated LED matrix (see 
+ * ledemu.h) and, optionally, to an observer function (e.g. to record
+ * them).
+ */
+
+#include <stdint.h>
+
+#include "spi.h"
+#include "spi_host.h"
+
+uint32_t spi_host_bytes_sent;
+LedEmulator spi_host_led;
+void (*spi_host_observer)(uint8_t byte);
+
+void spi_setup_master(uint8_t clockdivider) {
+	(void)clockdivider;
+}
+
+uint8_t spi_send_byte(uint8_t byte) {
+	spi_host_bytes_sent++;
+	ledemu_byte(&spi_host_led, byte);
+	if(spi_host_observer) {
+		spi_host_observer(byte);
+	}
+	return 0;
+}
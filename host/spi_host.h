@@ -0,0 +1,24 @@
+/*
+ * spi_host.h (host build)
+ *
+ * Host replacement for the SPI module - see spi_host.c
+ */
+
+#ifndef SPI_HOST_H_
+#define SPI_HOST_H_
+
+#include <stdint.h>
+
+#include "ledemu.h"
+
+// Number of bytes sent with spi_send_byte() so far
+extern uint32_t spi_host_bytes_sent;
+
+// The LED matrix the bytes are sent to. (It starts out all zero, i.e.
+// clear, so it doesn't need to be initialised.)
+extern LedEmulator spi_host_led;
+
+// If set, called with every byte sent
+extern void (*spi_host_observer)(uint8_t byte);
+
+#endif /* SPI_HOST_H_ */
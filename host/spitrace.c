@@ -0,0 +1,262 @@
+/*
+ * spitrace.c (host build)
+ *
+ * LED matrix SPI trace analyser. Reads an SPI capture (a
+ * SERIAL_FRAME_SPI_CAPTURE frame - see spi.h - in a log of the board's
+ * serial output, or written by headless -S), decodes it into the frames
+ * the LED matrix showed and works out how many bytes each frame would
+ * have taken with other ways of encoding the changes:
+ *     captured          - the bytes actually sent
+ *     per-pixel         - every pixel written sent as CMD_UPDATE_PIXEL
+ *     dirty framebuffer - only pixels that changed, as CMD_UPDATE_PIXEL
+ *     cheapest command  - the changes sent with whichever of pixel, row,
+ *                         column, update all or clear (plus updates)
+ *                         commands is cheapest for the frame
+ *     with shifts       - as cheapest command, but also trying a
+ *                         CMD_SHIFT_DISPLAY in each direction first
+ * A frame is a run of bytes no more than gap milliseconds apart (the
+ * game sends all of its changes for one time around the main loop in
+ * one go).
+ *
+ * If the capture doesn't start at reset (the ring buffer on the board
+ * wrapped around) the first (partial) frame is skipped and the next one
+ * is only used to find out what the display showed - pixels it didn't
+ * set are unknown, but they are the same before and after each later
+ * frame so they don't affect the comparison.
+ *
+ * Build (from the top level directory):
+ *     gcc -std=gnu99 -O2 -funsigned-char -Ihost -I. -o spitrace \
+ *         host/spitrace.c host/ledemu.c host/frame.c
+ *
+ * Usage:
+ *     spitrace [-g gap] capture_log
+ * The last capture in the log is used. gap defaults to 1 millisecond.
+ * Exit status is 0 if successful, 2 if no capture could be read.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "ledemu.h"
+#include "serialio.h"
+#include "spi.h"
+
+// Capture layout - see spi.h
+#define HEADER_SIZE	5
+#define ENTRY_SIZE	3
+
+// Command lengths in bytes
+#define PIXEL_BYTES	3
+#define ROW_BYTES	(2 + MATRIX_NUM_COLUMNS)
+#define COL_BYTES	(2 + MATRIX_NUM_ROWS)
+#define ALL_BYTES	(1 + MATRIX_NUM_COLUMNS * MATRIX_NUM_ROWS)
+#define CLEAR_BYTES	1
+#define SHIFT_BYTES	2
+
+typedef enum {
+	CAPTURED,
+	PER_PIXEL,
+	DIRTY_FRAMEBUFFER,
+	CHEAPEST_COMMAND,
+	WITH_SHIFTS,
+	NUM_STRATEGIES
+} Strategy;
+
+static const char* const strategy_names[NUM_STRATEGIES] = {
+	"captured", "per-pixel", "dirty framebuffer", "cheapest command",
+	"with shifts"
+};
+
+static uint32_t totals[NUM_STRATEGIES];
+static uint32_t worst[NUM_STRATEGIES];
+static uint32_t frames;
+
+static uint32_t min(uint32_t a, uint32_t b) {
+	return a < b ? a : b;
+}
+
+// Bytes needed to change the display from before to after using only
+// pixel, row and column commands (whichever is cheaper, row by row or
+// column by column)
+static uint32_t update_cost(MatrixData before, MatrixData after) {
+	uint32_t by_row = 0, by_column = 0;
+	uint32_t changed;
+
+	for(int x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		changed = 0;
+		for(int y = 0; y < MATRIX_NUM_ROWS; y++) {
+			changed += (before[x][y] != after[x][y]);
+		}
+		if(changed) {
+			by_column += min(changed * PIXEL_BYTES, COL_BYTES);
+		}
+	}
+	for(int y = 0; y < MATRIX_NUM_ROWS; y++) {
+		changed = 0;
+		for(int x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			changed += (before[x][y] != after[x][y]);
+		}
+		if(changed) {
+			by_row += min(changed * PIXEL_BYTES, ROW_BYTES);
+		}
+	}
+	return min(by_row, by_column);
+}
+
+static uint32_t cheapest_cost(MatrixData before, MatrixData after) {
+	MatrixData blank;
+	uint32_t cost;
+
+	memset(blank, COLOUR_BLACK, sizeof(blank));
+	cost = min(update_cost(before, after), ALL_BYTES);
+	return min(cost, CLEAR_BYTES + update_cost(blank, after));
+}
+
+static uint32_t shift_cost(MatrixData before, MatrixData after) {
+	static const int8_t directions[4][2] = {{1,0}, {-1,0}, {0,1}, {0,-1}};
+	MatrixData shifted;
+	uint32_t cost = cheapest_cost(before, after);
+
+	for(int i = 0; i < 4; i++) {
+		memcpy(shifted, before, sizeof(shifted));
+		ledemu_shift(shifted, directions[i][0], directions[i][1]);
+		cost = min(cost, SHIFT_BYTES + cheapest_cost(shifted, after));
+	}
+	return cost;
+}
+
+static uint32_t differences(MatrixData before, MatrixData after) {
+	uint32_t count = 0;
+
+	for(int x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		for(int y = 0; y < MATRIX_NUM_ROWS; y++) {
+			count += (before[x][y] != after[x][y]);
+		}
+	}
+	return count;
+}
+
+static void add_frame(MatrixData before, MatrixData after, uint32_t bytes,
+		uint32_t pixel_writes) {
+	uint32_t cost[NUM_STRATEGIES];
+
+	cost[CAPTURED] = bytes;
+	cost[PER_PIXEL] = pixel_writes * PIXEL_BYTES;
+	cost[DIRTY_FRAMEBUFFER] = differences(before, after) * PIXEL_BYTES;
+	cost[CHEAPEST_COMMAND] = cheapest_cost(before, after);
+	cost[WITH_SHIFTS] = shift_cost(before, after);
+	for(int i = 0; i < NUM_STRATEGIES; i++) {
+		totals[i] += cost[i];
+		if(cost[i] > worst[i]) {
+			worst[i] = cost[i];
+		}
+	}
+	frames++;
+}
+
+int main(int argc, char* argv[]) {
+	int gap = 1;
+	int option;
+	const char* filename;
+	uint8_t* log;
+	size_t log_length;
+	Frame frame;
+	uint32_t total_sent;
+	uint32_t entries;
+	const uint8_t* entry;
+	uint16_t time, last_time = 0;
+	uint32_t first = 0;
+	int skip_frames = 0;
+	LedEmulator led;
+	MatrixData before;
+	uint32_t frame_bytes = 0;
+	uint32_t writes_start = 0;
+
+	while((option = getopt(argc, argv, "g:")) != -1) {
+		if(option == 'g') {
+			gap = atoi(optarg);
+		} else {
+			optind = argc;
+			break;
+		}
+	}
+	if(optind != argc - 1) {
+		fprintf(stderr, "Usage: %s [-g gap] capture_log\n", argv[0]);
+		return 2;
+	}
+	filename = argv[optind];
+
+	log = read_file(filename, &log_length);
+	if(!log) {
+		return 2;
+	}
+	if(!frame_find_last(log, log_length, SERIAL_FRAME_SPI_CAPTURE, &frame) ||
+			frame.length < HEADER_SIZE ||
+			frame.data[0] != SPI_CAPTURE_VERSION) {
+		fprintf(stderr, "%s: no valid SPI capture found\n", filename);
+		return 2;
+	}
+	total_sent = frame.data[1] | (frame.data[2] << 8) |
+			(frame.data[3] << 16) | ((uint32_t)frame.data[4] << 24);
+	entries = (frame.length - HEADER_SIZE) / ENTRY_SIZE;
+
+	if(total_sent > entries) {
+		// We don't have the start - skip to the first frame boundary and
+		// use the frame after it to find out what's on the display
+		for(first = 1; first < entries; first++) {
+			entry = &frame.data[HEADER_SIZE + first * ENTRY_SIZE];
+			time = entry[1] | (entry[2] << 8);
+			if((uint16_t)(time - (entry[-2] | (entry[-1] << 8))) > gap) {
+				break;
+			}
+		}
+		skip_frames = 1;
+	}
+
+	ledemu_init(&led);
+	memcpy(before, led.pixels, sizeof(before));
+	for(uint32_t i = first; i <= entries; i++) {
+		if(i < entries) {
+			entry = &frame.data[HEADER_SIZE + i * ENTRY_SIZE];
+			time = entry[1] | (entry[2] << 8);
+		}
+		if(frame_bytes && (i == entries || (uint16_t)(time - last_time) > gap)) {
+			// End of a frame
+			if(skip_frames) {
+				skip_frames--;
+			} else {
+				add_frame(before, led.pixels, frame_bytes, 
+						led.pixel_writes - writes_start);
+			}
+			memcpy(before, led.pixels, sizeof(before));
+			frame_bytes = 0;
+			writes_start = led.pixel_writes;
+		}
+		if(i == entries) {
+			break;
+		}
+		ledemu_byte(&led, entry[0]);
+		frame_bytes++;
+		last_time = time;
+	}
+
+	printf("%u bytes captured (of %u sent), %u frames\n", entries,
+			total_sent, frames);
+	if(led.errors) {
+		printf("%u bytes weren't a valid command\n", led.errors);
+	}
+	if(frames == 0) {
+		free(log);
+		return 0;
+	}
+	printf("%-18s %8s %10s %8s\n", "strategy", "bytes", "per frame", "worst");
+	for(int i = 0; i < NUM_STRATEGIES; i++) {
+		printf("%-18s %8u %10.1f %8u\n", strategy_names[i], totals[i],
+				(double)totals[i] / frames, worst[i]);
+	}
+	free(log);
+	return 0;
+}
@@ -0,0 +1,13 @@
+/*
+ * util/delay.h (host shim)
+ *
+ * Busy-wait delays are meaningless on the host - they do nothing.
+ */
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#define _delay_ms(ms)	((void)(ms))
+#define _delay_us(us)	((void)(us))
+
+#endif /* HOST_UTIL_DELAY_H_ */
@@ -0,0 +1,305 @@
+/*
+ * vtemu.c (host build)
+ *
+ * Terminal emulator - see vtemu.h
+ */
+
+#include <string.h>
+
+#include "vtemu.h"
+
+// Escape sequence parser states
+#define STATE_NORMAL	0
+#define STATE_ESCAPE	1	// had ESC
+#define STATE_CSI		2	// had ESC [
+
+static void reset_attributes(VtEmulator* vt) {
+	vt->attributes.ch = ' ';
+	vt->attributes.fg = VT_DEFAULT_COLOUR;
+	vt->attributes.bg = VT_DEFAULT_COLOUR;
+	vt->attributes.flags = 0;
+}
+
+// Blank the cells from (x1, y) up to but not including (x2, y)
+static void erase(VtEmulator* vt, int y, int x1, int x2) {
+	VtCell blank = { ' ', VT_DEFAULT_COLOUR, VT_DEFAULT_COLOUR, 0 };
+
+	for(int x = x1; x < x2; x++) {
+		vt->screen[y][x] = blank;
+	}
+}
+
+void vtemu_init(VtEmulator* vt) {
+	memset(vt, 0, sizeof(*vt));
+	for(int y = 0; y < VT_ROWS; y++) {
+		erase(vt, y, 0, VT_COLUMNS);
+	}
+	reset_attributes(vt);
+	vt->bottom = VT_ROWS - 1;
+	vt->cursor_visible = 1;
+}
+
+// Scroll the rows from top to bottom up (direction 1) or down (-1) by
+// one row
+static void scroll(VtEmulator* vt, int direction) {
+	if(direction > 0) {
+		memmove(&vt->screen[vt->top], &vt->screen[vt->top + 1],
+				(vt->bottom - vt->top) * sizeof(vt->screen[0]));
+		erase(vt, vt->bottom, 0, VT_COLUMNS);
+	} else {
+		memmove(&vt->screen[vt->top + 1], &vt->screen[vt->top],
+				(vt->bottom - vt->top) * sizeof(vt->screen[0]));
+		erase(vt, vt->top, 0, VT_COLUMNS);
+	}
+}
+
+// Move the cursor down a row, scrolling if it's on the bottom row of the
+// scroll region
+static void index_down(VtEmulator* vt) {
+	if(vt->y == vt->bottom) {
+		scroll(vt, 1);
+	} else if(vt->y < VT_ROWS - 1) {
+		vt->y++;
+	}
+}
+
+static void index_up(VtEmulator* vt) {
+	if(vt->y == vt->top) {
+		scroll(vt, -1);
+	} else if(vt->y > 0) {
+		vt->y--;
+	}
+}
+
+static void put_char(VtEmulator* vt, char ch) {
+	if(vt->x >= VT_COLUMNS) {
+		// Wrap on to the next line
+		vt->x = 0;
+		index_down(vt);
+	}
+	vt->screen[vt->y][vt->x] = vt->attributes;
+	vt->screen[vt->y][vt->x].ch = ch;
+	vt->x++;
+}
+
+// Parameter i of the escape sequence, or def if it wasn't given (or was 0
+// where 0 isn't meaningful)
+static int param(VtEmulator* vt, int i, int def) {
+	if(i >= vt->num_params || vt->params[i] == 0) {
+		return def;
+	}
+	return vt->params[i];
+}
+
+static int clamp(int value, int low, int high) {
+	return value < low ? low : (value > high ? high : value);
+}
+
+static void select_graphic_rendition(VtEmulator* vt) {
+	int value;
+
+	if(vt->num_params == 0) {
+		reset_attributes(vt);
+		return;
+	}
+	for(int i = 0; i < vt->num_params; i++) {
+		value = vt->params[i];
+		if(value == 0) {
+			reset_attributes(vt);
+		} else if(value == 1) {
+			vt->attributes.flags |= VT_BRIGHT;
+		} else if(value == 2) {
+			vt->attributes.flags &= ~VT_BRIGHT;
+		} else if(value == 4) {
+			vt->attributes.flags |= VT_UNDERSCORE;
+		} else if(value == 5) {
+			vt->attributes.flags |= VT_BLINK;
+		} else if(value == 7) {
+			vt->attributes.flags |= VT_REVERSE;
+		} else if(value == 8) {
+			vt->attributes.flags |= VT_HIDDEN;
+		} else if(value >= 30 && value <= 37) {
+			vt->attributes.fg = value - 30;
+		} else if(value == 39) {
+			vt->attributes.fg = VT_DEFAULT_COLOUR;
+		} else if(value >= 40 && value <= 47) {
+			vt->attributes.bg = value - 40;
+		} else if(value == 49) {
+			vt->attributes.bg = VT_DEFAULT_COLOUR;
+		} else {
+			vt->unknown++;
+		}
+	}
+}
+
+// Carry out a complete ESC [ ... sequence ending in the given character
+static void control_sequence(VtEmulator* vt, char final) {
+	int mode;
+
+	if(vt->private_mode) {
+		if(param(vt, 0, 0) == 25 && (final == 'h' || final == 'l')) {
+			vt->cursor_visible = (final == 'h');
+		} else {
+			vt->unknown++;
+		}
+		return;
+	}
+	switch(final) {
+		case 'H':
+		case 'f':
+			vt->y = clamp(param(vt, 0, 1) - 1, 0, VT_ROWS - 1);
+			vt->x = clamp(param(vt, 1, 1) - 1, 0, VT_COLUMNS - 1);
+			break;
+		case 'J':
+			mode = vt->num_params ? vt->params[0] : 0;
+			if(mode == 0) {
+				erase(vt, vt->y, vt->x, VT_COLUMNS);
+				for(int y = vt->y + 1; y < VT_ROWS; y++) {
+					erase(vt, y, 0, VT_COLUMNS);
+				}
+			} else if(mode == 1) {
+				for(int y = 0; y < vt->y; y++) {
+					erase(vt, y, 0, VT_COLUMNS);
+				}
+				erase(vt, vt->y, 0, vt->x + 1);
+			} else {
+				for(int y = 0; y < VT_ROWS; y++) {
+					erase(vt, y, 0, VT_COLUMNS);
+				}
+			}
+			break;
+		case 'K':
+			mode = vt->num_params ? vt->params[0] : 0;
+			if(mode == 0) {
+				erase(vt, vt->y, vt->x, VT_COLUMNS);
+			} else if(mode == 1) {
+				erase(vt, vt->y, 0, vt->x + 1);
+			} else {
+				erase(vt, vt->y, 0, VT_COLUMNS);
+			}
+			break;
+		case 'r':
+			vt->top = clamp(param(vt, 0, 1) - 1, 0, VT_ROWS - 1);
+			vt->bottom = clamp(param(vt, 1, VT_ROWS) - 1, 0, VT_ROWS - 1);
+			if(vt->top >= vt->bottom) {
+				vt->top = 0;
+				vt->bottom = VT_ROWS - 1;
+			}
+			vt->x = 0;
+			vt->y = 0;
+			break;
+		case 'm':
+			select_graphic_rendition(vt);
+			break;
+		default:
+			vt->unknown++;
+			break;
+	}
+}
+
+void vtemu_byte(VtEmulator* vt, uint8_t byte) {
+	vt->bytes++;
+	switch(vt->state) {
+		case STATE_NORMAL:
+			if(byte == 0x1B) {
+				vt->state = STATE_ESCAPE;
+			} else if(byte == '\r') {
+				vt->x = 0;
+			} else if(byte == '\n') {
+				index_down(vt);
+			} else if(byte == '\b') {
+				if(vt->x > 0) {
+					vt->x--;
+				}
+			} else if(byte >= ' ' && byte < 0x7F) {
+				put_char(vt, byte);
+			} else {
+				vt->unknown++;
+			}
+			break;
+		case STATE_ESCAPE:
+			vt->state = STATE_NORMAL;
+			if(byte == '[') {
+				vt->state = STATE_CSI;
+				vt->num_params = 0;
+				vt->private_mode = 0;
+			} else if(byte == 'M') {
+				index_up(vt);
+			} else if(byte == 'D') {
+				index_down(vt);
+			} else {
+				vt->unknown++;
+			}
+			break;
+		case STATE_CSI:
+			if(byte == '?') {
+				vt->private_mode = 1;
+			} else if(byte >= '0' && byte <= '9') {
+				if(vt->num_params == 0) {
+					vt->num_params = 1;
+					vt->params[0] = 0;
+				}
+				vt->params[vt->num_params - 1] =
+						vt->params[vt->num_params - 1] * 10 + (byte - '0');
+			} else if(byte == ';') {
+				if(vt->num_params == 0) {
+					// Empty first number
+					vt->params[vt->num_params++] = 0;
+				}
+				if(vt->num_params < VT_MAX_PARAMS) {
+					vt->params[vt->num_params++] = 0;
+				}
+			} else {
+				vt->state = STATE_NORMAL;
+				control_sequence(vt, byte);
+			}
+			break;
+	}
+}
+
+// Character to show for a cell in vtemu_write_text()
+static char cell_char(const VtCell* cell) {
+	static const char colour_letters[] = "krgybmcw";
+
+	if(cell->ch != ' ') {
+		return cell->ch;
+	} else if(cell->flags & VT_REVERSE) {
+		return '#';
+	} else if(cell->bg < 8) {
+		return colour_letters[cell->bg];
+	}
+	return ' ';
+}
+
+void vtemu_write_text(const VtEmulator* vt, FILE* file) {
+	char line[VT_COLUMNS + 1];
+	int rows = VT_ROWS;
+	int length;
+
+	fprintf(file, "cursor %d,%d %s\n", vt->x + 1, vt->y + 1,
+			vt->cursor_visible ? "shown" : "hidden");
+
+	// Leave off blank rows at the bottom
+	while(rows > 0) {
+		for(length = 0; length < VT_COLUMNS; length++) {
+			if(cell_char(&vt->screen[rows - 1][length]) != ' ') {
+				break;
+			}
+		}
+		if(length < VT_COLUMNS) {
+			break;
+		}
+		rows--;
+	}
+	for(int y = 0; y < rows; y++) {
+		length = 0;
+		for(int x = 0; x < VT_COLUMNS; x++) {
+			line[x] = cell_char(&vt->screen[y][x]);
+			if(line[x] != ' ') {
+				length = x + 1;
+			}
+		}
+		line[length] = '\0';
+		fprintf(file, "%s\n", line);
+	}
+}
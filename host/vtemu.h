@@ -0,0 +1,86 @@
+/*
+ * vtemu.h (host build)
+ *
+ * Terminal emulator. Takes the bytes the game sends to the serial
+ * terminal one at a time and keeps track of what the terminal would be
+ * showing. It understands the subset of VT100/ANSI escape sequences
+ * that terminalio.c uses:
+ *     ESC [ row ; column H       move the cursor
+ *     ESC [ n J, ESC [ n K       erase (screen or line)
+ *     ESC [ top ; bottom r       set (or with no numbers, reset) the
+ *                                scroll region
+ *     ESC M, ESC D               scroll down / up (reverse index / index)
+ *     ESC [ n ; ... m            display attributes (SGR)
+ *     ESC [ ? 25 l, ESC [ ? 25 h hide / show the cursor
+ * along with CR, LF and backspace. Anything else is counted (see
+ * unknown) and ignored.
+ */
+
+#ifndef VTEMU_H_
+#define VTEMU_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define VT_COLUMNS	80
+#define VT_ROWS		40
+
+// Maximum number of numbers in an escape sequence
+#define VT_MAX_PARAMS 8
+
+// Cell attributes. Colours are 0 to 7 as for SGR 30-37 / 40-47, or
+// VT_DEFAULT_COLOUR.
+#define VT_DEFAULT_COLOUR	9
+#define VT_BRIGHT			0x01
+#define VT_UNDERSCORE		0x02
+#define VT_BLINK			0x04
+#define VT_REVERSE			0x08
+#define VT_HIDDEN			0x10
+
+typedef struct {
+	char ch;
+	uint8_t fg;
+	uint8_t bg;
+	uint8_t flags;
+} VtCell;
+
+typedef struct {
+	VtCell screen[VT_ROWS][VT_COLUMNS];
+
+	// Cursor position (0 based), the attributes characters are written
+	// with, the scroll region (first and last rows, 0 based) and whether
+	// the cursor is shown
+	int x, y;
+	VtCell attributes;
+	int top, bottom;
+	int cursor_visible;
+
+	// Escape sequence being received
+	int state;
+	int params[VT_MAX_PARAMS];
+	int num_params;
+	int private_mode;
+
+	// Totals - bytes received and escape sequences (or control
+	// characters) that weren't understood
+	uint32_t bytes;
+	uint32_t unknown;
+} VtEmulator;
+
+// Start with a blank screen, the cursor at the top left and no scroll
+// region
+void vtemu_init(VtEmulator* vt);
+
+// Receive one byte
+void vtemu_byte(VtEmulator* vt, uint8_t byte);
+
+// Write the screen as text. The first line gives the cursor position (1
+// based, as for move_cursor()) and whether it's shown. Then each row
+// follows (trailing blanks and blank rows at the bottom are left off).
+// Blank cells with a background colour are shown as the first letter of
+// the colour in lower case (e.g. 'g' for green) and reverse video blanks
+// as '#', so that coloured areas (e.g. the playing field) can be seen
+// and compared.
+void vtemu_write_text(const VtEmulator* vt, FILE* file);
+
+#endif /* VTEMU_H_ */
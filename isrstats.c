@@ -0,0 +1,155 @@
+/*
+ * isrstats.c
+ *
+ * Interrupt latency instrumentation - see isrstats.h.
+ *
+ * Timer 1 runs from the undivided 8MHz clock in CTC mode with a period of
+ * 8000 cycles - the same period as timer 0 (which divides by 64 and counts
+ * to 124). Both timers are started from the same prescaler reset, so timer 1
+ * clears to 0 at the same moment timer 0 matches and raises its interrupt
+ * flag. The value of TCNT1 at any point is therefore the number of cycles
+ * since the most recent timer 0 compare match.
+ */
+
+#include "isrstats.h"
+
+#ifdef ISR_STATS
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "terminalio.h"
+
+// Period of timer 0 (and so timer 1) in CPU cycles
+#define CYCLES_PER_TICK 8000
+
+// Statistics for the TIMER0_COMPA_vect entry latency
+static volatile uint16_t timer0_latency_max;
+static volatile uint16_t timer0_latency_hist[ISR_STATS_BUCKETS];
+
+// Statistics for each interrupts-disabled site
+static volatile uint16_t site_max[CS_NUM_SITES];
+static volatile uint16_t site_hist[CS_NUM_SITES][ISR_STATS_BUCKETS];
+
+static const char site_name_0[] PROGMEM = "uart_put_char";
+static const char site_name_1[] PROGMEM = "uart_get_char";
+static const char site_name_2[] PROGMEM = "button_pushed";
+static const char site_name_3[] PROGMEM = "TIMER0_COMPA_vect";
+static const char site_name_4[] PROGMEM = "PCINT1_vect";
+static const char site_name_5[] PROGMEM = "USART0_RX_vect";
+static const char site_name_6[] PROGMEM = "USART0_UDRE_vect";
+
+static const char* const site_names[CS_NUM_SITES] PROGMEM = {
+		site_name_0, site_name_1, site_name_2, site_name_3,
+		site_name_4, site_name_5, site_name_6 };
+
+// Work out which histogram bucket a cycle count belongs in
+static uint8_t bucket_for(uint16_t cycles) {
+	uint8_t bucket = 0;
+	cycles >>= 4;
+	while(cycles && bucket < ISR_STATS_BUCKETS - 1) {
+		cycles >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+static void add_to_histogram(volatile uint16_t* hist, uint16_t cycles) {
+	uint8_t bucket = bucket_for(cycles);
+	// Saturate rather than wrap around
+	if(hist[bucket] != 0xFFFF) {
+		hist[bucket]++;
+	}
+}
+
+void isrstats_init(void) {
+	// Stop the prescaler shared by timers 0 and 1 and reset it so that
+	// both timers start counting from the same clock edge.
+	GTCCR = (1<<TSM)|(1<<PSRSYNC);
+
+	TCNT0 = 0;
+	TCNT1 = 0;
+
+	// CTC mode, no prescaling, clear after 8000 cycles
+	OCR1A = CYCLES_PER_TICK - 1;
+	TCCR1A = 0;
+	TCCR1B = (1<<WGM12)|(1<<CS10);
+
+	// Release the prescaler - both timers start together
+	GTCCR = 0;
+
+	isrstats_reset();
+}
+
+void isrstats_reset(void) {
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	timer0_latency_max = 0;
+	for(uint8_t b = 0; b < ISR_STATS_BUCKETS; b++) {
+		timer0_latency_hist[b] = 0;
+		for(uint8_t site = 0; site < CS_NUM_SITES; site++) {
+			site_hist[site][b] = 0;
+		}
+	}
+	for(uint8_t site = 0; site < CS_NUM_SITES; site++) {
+		site_max[site] = 0;
+	}
+	if(interrupts_were_enabled) {
+		sei();
+	}
+}
+
+void isrstats_timer0_entry(void) {
+	// Timer 1 cleared to zero at the compare match, so its count is
+	// how late we are.
+	uint16_t latency = TCNT1;
+
+	if(latency > timer0_latency_max) {
+		timer0_latency_max = latency;
+	}
+	add_to_histogram(timer0_latency_hist, latency);
+}
+
+void isrstats_record(CriticalSite site, uint16_t start) {
+	uint16_t now = TCNT1;
+	uint16_t cycles;
+
+	// Allow for timer 1 having wrapped around during the window
+	if(now >= start) {
+		cycles = now - start;
+	} else {
+		cycles = now + CYCLES_PER_TICK - start;
+	}
+
+	if(cycles > site_max[site]) {
+		site_max[site] = cycles;
+	}
+	add_to_histogram(site_hist[site], cycles);
+}
+
+static void print_histogram(volatile uint16_t* hist, uint16_t max) {
+	printf_P(PSTR("%5u |"), max);
+	for(uint8_t b = 0; b < ISR_STATS_BUCKETS; b++) {
+		printf_P(PSTR(" %5u"), hist[b]);
+	}
+	printf_P(PSTR("\n"));
+}
+
+void isrstats_print(void) {
+	// Values are read while the interrupts are still running, so
+	// counts may change while we're printing them.
+	move_cursor(1, 25);
+	clear_to_end_of_line();
+	printf_P(PSTR("%-18S   max |   <16   <32   <64  <128  <256  <512   <1K   <2K   <4K   <8K\n"),
+			PSTR("cycles"));
+	printf_P(PSTR("%-18S "), PSTR("TIMER0 latency"));
+	print_histogram(timer0_latency_hist, timer0_latency_max);
+	for(uint8_t site = 0; site < CS_NUM_SITES; site++) {
+		printf_P(PSTR("%-18S "), (const char*)pgm_read_ptr(&site_names[site]));
+		print_histogram(site_hist[site], site_max[site]);
+	}
+}
+
+#endif /* ISR_STATS */
@@ -0,0 +1,89 @@
+/*
+ * isrstats.h
+ *
+ * Interrupt latency instrumentation. When enabled, timer 1 is run from
+ * the undivided system clock in lock step with timer 0 so that its count
+ * is always the number of CPU cycles since the last timer 0 compare match.
+ * This lets us measure
+ * (1) how late each TIMER0_COMPA_vect entry is relative to the compare
+ *     match that triggered it, and
+ * (2) how long interrupts are disabled at each call site that turns them
+ *     off (and for how long each interrupt handler runs).
+ * Results are kept as a maximum plus a log2-bucket histogram and can be
+ * printed to the serial terminal with isrstats_print().
+ *
+ * Measurements are in CPU cycles (125ns at 8MHz). Windows longer than
+ * one timer 0 period (8000 cycles) wrap around and can't be measured.
+ */
+
+#ifndef ISRSTATS_H_
+#define ISRSTATS_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+
+// Uncomment (or define ISR_STATS in the project symbols) to compile in
+// the instrumentation. Without it all of the macros below expand to
+// nothing and timer 1 is left untouched.
+//#define ISR_STATS
+
+// Places where interrupts are disabled. The first group are the critical
+// sections in our library code, the second group are interrupt handlers
+// (which run with interrupts disabled).
+typedef enum {
+	CS_UART_PUT_CHAR,
+	CS_UART_GET_CHAR,
+	CS_BUTTON_PUSHED,
+	CS_ISR_TIMER0,
+	CS_ISR_PCINT1,
+	CS_ISR_USART_RX,
+	CS_ISR_USART_UDRE,
+	CS_NUM_SITES
+} CriticalSite;
+
+// Histogram bucket 0 counts values below 16 cycles, bucket n (n >= 1)
+// counts values from 2^(n+3) to 2^(n+4)-1, so the last bucket covers
+// 4096 to 7999 cycles.
+#define ISR_STATS_BUCKETS 10
+
+#ifdef ISR_STATS
+
+// Current position within the timer 0 period, in CPU cycles (0 to 7999)
+#define isrstats_now()	(TCNT1)
+
+// Set up timer 1 and synchronise it with timer 0. Must be called after
+// init_timer0() and before interrupts are enabled.
+void isrstats_init(void);
+
+// Clear all of the statistics collected so far
+void isrstats_reset(void);
+
+// Record the entry to TIMER0_COMPA_vect. Must be the first thing the
+// handler does.
+void isrstats_timer0_entry(void);
+
+// Record an interrupts-disabled window at the given site which started
+// at the given isrstats_now() value. Must be called with interrupts
+// still disabled.
+void isrstats_record(CriticalSite site, uint16_t start);
+
+// Print the statistics to the serial terminal
+void isrstats_print(void);
+
+// Wrap a critical section (or the body of an interrupt handler).
+// ISR_STATS_BEGIN() declares a variable so must be at the start of a block.
+#define ISR_STATS_BEGIN()			uint16_t isr_stats_start = isrstats_now()
+#define ISR_STATS_END(site)			isrstats_record((site), isr_stats_start)
+
+#else
+
+#define isrstats_init()
+#define isrstats_reset()
+#define isrstats_timer0_entry()
+#define isrstats_print()
+#define ISR_STATS_BEGIN()
+#define ISR_STATS_END(site)
+
+#endif /* ISR_STATS */
+
+#endif /* ISRSTATS_H_ */
@@ -10,18 +10,46 @@
 #include "ledmatrix.h"
 #include "spi.h"
 
-#define CMD_UPDATE_ALL 0x00
-#define CMD_UPDATE_PIXEL 0x01
-#define CMD_UPDATE_ROW 0x02
-#define CMD_UPDATE_COL 0x03
-#define CMD_SHIFT_DISPLAY 0x04
-#define CMD_CLEAR_SCREEN 0x0F
+#define F_CPU 8000000L
+#include <util/delay.h>
+
+
+// The LED matrix takes longer to carry out CMD_UPDATE_ALL and 
+// CMD_CLEAR_SCREEN than the other commands. When the clock is divided by
+// 128 each byte takes 128us to send, which gives it time to finish 
+// before the next command arrives (so the SPI buffer on the LED matrix
+// never overflows). At faster speeds we wait SLOW_COMMAND_GAP 
+// microseconds after these commands before sending anything else. Other
+// commands are sent back to back.
+#define SAFE_DIVIDER		128
+#define SLOW_COMMAND_GAP	1000
+#define PACE_STEP			50
+
+static uint8_t spi_divider;
+static uint8_t pace_steps;
+
+static void pace(void) {
+	for(uint8_t i = pace_steps; i > 0; i--) {
+		_delay_us(PACE_STEP);
+	}
+}
 
 void ledmatrix_setup(void) {
-	// Setup SPI - we divide the clock by 128.
-	// (This speed guarantees the SPI buffer will never overflow on
-	// the LED matrix.)
-	spi_setup_master(128);
+	ledmatrix_set_spi_divider(LEDMATRIX_SPI_DIVIDER);
+}
+
+void ledmatrix_set_spi_divider(uint8_t clockdivider) {
+	spi_divider = clockdivider;
+	if(clockdivider >= SAFE_DIVIDER) {
+		pace_steps = 0;
+	} else {
+		pace_steps = SLOW_COMMAND_GAP / PACE_STEP;
+	}
+	spi_setup_master(clockdivider);
+}
+
+uint8_t ledmatrix_get_spi_divider(void) {
+	return spi_divider;
 }
 
 void ledmatrix_update_all(MatrixData data) {
@@ -31,6 +59,7 @@ void ledmatrix_update_all(MatrixData data) {
 			(void)spi_send_byte(data[x][y]);
 		}
 	}
+	pace();
 }
 
 void ledmatrix_update_pixel(uint8_t x, uint8_t y, PixelColour pixel) {
@@ -69,26 +98,81 @@ void ledmatrix_update_column(uint8_t x, MatrixColumn col) {
 
 void ledmatrix_shift_display_left(void) {
 	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x02);
+	(void)spi_send_byte(SHIFT_LEFT);
 }
 
 void ledmatrix_shift_display_right(void) {
 	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x01);
+	(void)spi_send_byte(SHIFT_RIGHT);
 }
 
 void ledmatrix_shift_display_up(void) {
 	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x08);
+	(void)spi_send_byte(SHIFT_UP);
 }
 
 void ledmatrix_shift_display_down(void) {
 	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x04);
+	(void)spi_send_byte(SHIFT_DOWN);
 }
 
 void ledmatrix_clear(void) {
 	(void)spi_send_byte(CMD_CLEAR_SCREEN);
+	pace();
+}
+
+// Number of times the self test pattern is sent
+#define SELF_TEST_ROUNDS 10
+
+PixelColour ledmatrix_self_test_colour(uint8_t x, uint8_t y) {
+	if(x == 0 || x == MATRIX_NUM_COLUMNS - 1 || y == 0 || 
+			y == MATRIX_NUM_ROWS - 1) {
+		return COLOUR_GREEN;
+	} else if((x + y) % 3 == 0) {
+		return COLOUR_RED;
+	} else {
+		return COLOUR_BLACK;
+	}
+}
+
+void ledmatrix_self_test_pattern(void) {
+	MatrixData data;
+	MatrixRow row;
+	MatrixColumn col;
+	PixelColour colour;
+	
+	for(uint8_t round = 0; round < SELF_TEST_ROUNDS; round++) {
+		// Start with the whole display yellow - the pattern has no
+		// yellow so any left over shows a missed update
+		ledmatrix_clear();
+		for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			set_matrix_column_to_colour(data[x], COLOUR_YELLOW);
+		}
+		ledmatrix_update_all(data);
+		
+		// Each row, except for column 0 and the red pixels
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			row[0] = COLOUR_YELLOW;
+			for(uint8_t x = 1; x < MATRIX_NUM_COLUMNS; x++) {
+				colour = ledmatrix_self_test_colour(x, y);
+				row[x] = (colour == COLOUR_RED) ? COLOUR_BLACK : colour;
+			}
+			ledmatrix_update_row(y, row);
+		}
+		
+		// Column 0, then the red pixels one at a time
+		for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+			col[y] = ledmatrix_self_test_colour(0, y);
+		}
+		ledmatrix_update_column(0, col);
+		for(uint8_t x = 1; x < MATRIX_NUM_COLUMNS; x++) {
+			for(uint8_t y = 0; y < MATRIX_NUM_ROWS; y++) {
+				if(ledmatrix_self_test_colour(x, y) == COLOUR_RED) {
+					ledmatrix_update_pixel(x, y, COLOUR_RED);
+				}
+			}
+		}
+	}
 }
 
 void copy_matrix_column(MatrixColumn from, MatrixColumn to) {
@@ -114,3 +198,72 @@ void set_matrix_row_to_colour(MatrixRow matrix_row, PixelColour colour) {
 		matrix_row[column] = colour;
 	}
 }
+
+// Palette index of a packed pixel
+static uint8_t packed_index(const PackedMatrixData* data, uint8_t x, uint8_t y) {
+	uint8_t byte = data->pixels[x][y >> 1];
+	return (y & 1) ? (byte >> 4) : (byte & 0x0F);
+}
+
+void packed_matrix_clear(PackedMatrixData* data) {
+	for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		for(uint8_t i = 0; i < MATRIX_NUM_ROWS / 2; i++) {
+			data->pixels[x][i] = 0;
+		}
+	}
+	data->palette[0] = COLOUR_BLACK;
+	data->palette_size = 1;
+}
+
+PixelColour packed_matrix_get(const PackedMatrixData* data, uint8_t x, uint8_t y) {
+	return data->palette[packed_index(data, x, y)];
+}
+
+uint8_t packed_matrix_set(PackedMatrixData* data, uint8_t x, uint8_t y, 
+		PixelColour colour) {
+	uint8_t index;
+	uint16_t in_use;
+	uint8_t stored = 1;
+	
+	// Look for the colour in the palette, adding it if there's room
+	for(index = 0; index < data->palette_size; index++) {
+		if(data->palette[index] == colour) {
+			break;
+		}
+	}
+	if(index == PACKED_PALETTE_SIZE) {
+		// The palette is full - reuse an entry that no pixel (other than
+		// the one we're changing) uses
+		in_use = 1;
+		for(uint8_t px = 0; px < MATRIX_NUM_COLUMNS; px++) {
+			for(uint8_t py = 0; py < MATRIX_NUM_ROWS; py++) {
+				if(px != x || py != y) {
+					in_use |= ((uint16_t)1 << packed_index(data, px, py));
+				}
+			}
+		}
+		for(index = 1; index < PACKED_PALETTE_SIZE; index++) {
+			if(!(in_use & ((uint16_t)1 << index))) {
+				break;
+			}
+		}
+		if(index == PACKED_PALETTE_SIZE) {
+			// No room - the pixel is made black so that it no longer
+			// holds on to a palette entry
+			index = 0;
+			stored = 0;
+		} else {
+			data->palette[index] = colour;
+		}
+	} else if(index == data->palette_size) {
+		data->palette[index] = colour;
+		data->palette_size++;
+	}
+	
+	if(y & 1) {
+		data->pixels[x][y >> 1] = (data->pixels[x][y >> 1] & 0x0F) | (index << 4);
+	} else {
+		data->pixels[x][y >> 1] = (data->pixels[x][y >> 1] & 0xF0) | index;
+	}
+	return stored;
+}
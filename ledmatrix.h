@@ -22,11 +22,69 @@ typedef PixelColour MatrixData[MATRIX_NUM_COLUMNS][MATRIX_NUM_ROWS];
 typedef PixelColour MatrixRow[MATRIX_NUM_COLUMNS];
 typedef PixelColour MatrixColumn[MATRIX_NUM_ROWS];
 
+// SPI commands understood by the LED matrix (see the LED matrix 
+// Reference). The command byte is followed by
+//     CMD_UPDATE_ALL     128 colours - row 0 (x = 0 to 15) first
+//     CMD_UPDATE_PIXEL   (y << 4) | x, colour
+//     CMD_UPDATE_ROW     y, 16 colours (x = 0 to 15)
+//     CMD_UPDATE_COL     x, 8 colours (y = 0 to 7)
+//     CMD_SHIFT_DISPLAY  direction (SHIFT_...)
+//     CMD_CLEAR_SCREEN   nothing
+#define CMD_UPDATE_ALL 0x00
+#define CMD_UPDATE_PIXEL 0x01
+#define CMD_UPDATE_ROW 0x02
+#define CMD_UPDATE_COL 0x03
+#define CMD_SHIFT_DISPLAY 0x04
+#define CMD_CLEAR_SCREEN 0x0F
+
+#define SHIFT_RIGHT 0x01
+#define SHIFT_LEFT 0x02
+#define SHIFT_DOWN 0x04
+#define SHIFT_UP 0x08
+
+// Packed display data. Each pixel is a 4 bit index into a palette of up
+// to PACKED_PALETTE_SIZE colours (two pixels per byte), so a whole display
+// takes 64 bytes plus the palette rather than 128 bytes. Pixels are only
+// expanded to PixelColour when they're read.
+// Palette entry 0 is always black. Other entries are added as colours 
+// are used, and reused once no pixel uses them.
+// This is only used for the compositor's copy of what the LED matrix is
+// showing (see compositor.c). Nothing sends a packed frame to the LED
+// matrix - changed cells are sent one at a time - and no second (double
+// buffered) frame is kept, as the compositor already only sends the cells
+// that changed. (The terminal's copy of the playing field is packed 
+// separately, at 2 bits per cell - see display.c.)
+#define PACKED_PALETTE_SIZE 16
+typedef struct {
+	uint8_t pixels[MATRIX_NUM_COLUMNS][MATRIX_NUM_ROWS / 2];
+	PixelColour palette[PACKED_PALETTE_SIZE];
+	uint8_t palette_size;
+} PackedMatrixData;
+
+// SPI clock divider used by ledmatrix_setup() (one of 2, 4, 8, 16, 32, 
+// 64 or 128). At 128 the LED matrix can always keep up. At faster speeds
+// we leave gaps after the commands the matrix is slow to carry out (see
+// ledmatrix.c) - ledmatrix_self_test_pattern() can be used to check that
+// a speed works with a particular board.
+#define LEDMATRIX_SPI_DIVIDER 128
+
 // Setup SPI communication with the LED matrix.
 // This function must be called before the LED matrix functions
 // below are used.
 void ledmatrix_setup(void);
 
+// Change (or return) the SPI clock divider. 
+void ledmatrix_set_spi_divider(uint8_t clockdivider);
+uint8_t ledmatrix_get_spi_divider(void);
+
+// Self test. Sends several rounds of every kind of update (back to back,
+// as fast as the current divider allows) which should leave the display
+// showing ledmatrix_self_test_colour() for each pixel - a green border
+// with red diagonal stripes. If the LED matrix has missed any bytes the
+// display will be different (e.g. yellow pixels left over).
+void ledmatrix_self_test_pattern(void);
+PixelColour ledmatrix_self_test_colour(uint8_t x, uint8_t y);
+
 // Functions to update the display
 // For those functions which take an x or a y value, the value must be valid
 // or the request will be ignored. (i.e. x must be < MATRIX_NUM_COLUMNS
@@ -47,4 +105,13 @@ void copy_matrix_row(MatrixRow from, MatrixRow to);
 void set_matrix_column_to_colour(MatrixColumn matrix_column, PixelColour colour);
 void set_matrix_row_to_colour(MatrixRow matrix_row, PixelColour colour);
 
+// Functions to operate on PackedMatrixData. packed_matrix_clear() sets
+// every pixel to black and empties the palette. packed_matrix_set() 
+// returns 1 if successful, or 0 if the palette is full of colours that
+// are all in use (the pixel is then set to black). x and y must be valid.
+void packed_matrix_clear(PackedMatrixData* data);
+PixelColour packed_matrix_get(const PackedMatrixData* data, uint8_t x, uint8_t y);
+uint8_t packed_matrix_set(PackedMatrixData* data, uint8_t x, uint8_t y, 
+		PixelColour colour);
+
 #endif /* LEDMATRIX_H_ */
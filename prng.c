@@ -0,0 +1,127 @@
+/*
+ * prng.c
+ *
+ * 16 bit xorshift pseudo random number generator - see prng.h
+ */
+
+#include <stdint.h>
+
+#include "prng.h"
+#include "isrstats.h"
+
+/* Value used in place of a zero seed (which would make the generator
+ * return 0 forever)
+ */
+#define DEFAULT_SEED 0xACE1
+
+static uint16_t seed;
+static uint16_t state = DEFAULT_SEED;
+
+void prng_seed(uint16_t new_seed) {
+	seed = new_seed;
+	if(new_seed == 0) {
+		state = DEFAULT_SEED;
+	} else {
+		state = new_seed;
+	}
+}
+
+uint16_t prng_get_seed(void) {
+	return seed;
+}
+
+uint16_t prng_next(void) {
+	state ^= state << 7;
+	state ^= state >> 9;
+	state ^= state << 8;
+	return state;
+}
+
+uint8_t prng_below(uint8_t bound) {
+	/* We take a random byte r and compute r * bound. The high byte of
+	 * this product is in the range 0 to bound-1. To avoid bias we reject
+	 * products whose low byte falls below (256 % bound) - see Lemire,
+	 * "Fast Random Integer Generation in an Interval". This needs just
+	 * an 8x8 bit hardware multiply; the division is only needed on the
+	 * (rare) occasions the low byte is less than bound.
+	 */
+	uint16_t product = (uint16_t)(uint8_t)(prng_next() >> 8) * bound;
+	uint8_t low = (uint8_t)product;
+	if(low < bound) {
+		uint8_t threshold = (uint8_t)(256 - bound) % bound;
+		while(low < threshold) {
+			product = (uint16_t)(uint8_t)(prng_next() >> 8) * bound;
+			low = (uint8_t)product;
+		}
+	}
+	return product >> 8;
+}
+
+#ifdef ISR_STATS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "terminalio.h"
+#include "game.h"
+
+#define BENCHMARK_DRAWS 64
+
+/* Cycle count between two isrstats_now() values (allowing for a
+ * wraparound at the end of the timer 0 period)
+ */
+static uint16_t cycles_between(uint16_t start, uint16_t end) {
+	if(end >= start) {
+		return end - start;
+	}
+	return end + 8000 - start;
+}
+
+void prng_benchmark(void) {
+	uint32_t totals[4] = {0, 0, 0, 0};
+	uint16_t start;
+	volatile uint16_t sink;
+	uint16_t saved_state = state;
+	
+	/* Time each draw separately with interrupts off so that neither
+	 * interrupt handlers nor a timer wraparound can affect the result.
+	 * totals[0] measures the timing overhead itself.
+	 */
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	for(uint8_t i = 0; i < BENCHMARK_DRAWS; i++) {
+		cli();
+		start = isrstats_now();
+		sink = 0;
+		totals[0] += cycles_between(start, isrstats_now());
+		start = isrstats_now();
+		sink = prng_next();
+		totals[1] += cycles_between(start, isrstats_now());
+		start = isrstats_now();
+		sink = prng_below(FIELD_WIDTH);
+		totals[2] += cycles_between(start, isrstats_now());
+		start = isrstats_now();
+		sink = (uint16_t)random();
+		totals[3] += cycles_between(start, isrstats_now());
+		if(interrupts_were_enabled) {
+			sei();
+		}
+	}
+	(void)sink;
+	
+	/* Put the generator back the way it was so that running the
+	 * benchmark doesn't change the game
+	 */
+	state = saved_state;
+	
+	move_cursor(1, 25);
+	clear_to_end_of_line();
+	printf_P(PSTR("cycles/draw: prng_next %lu, prng_below %lu, random %lu\n"),
+			(totals[1] - totals[0]) / BENCHMARK_DRAWS,
+			(totals[2] - totals[0]) / BENCHMARK_DRAWS,
+			(totals[3] - totals[0]) / BENCHMARK_DRAWS);
+}
+
+#endif /* ISR_STATS */
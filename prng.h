@@ -0,0 +1,49 @@
+/*
+ * prng.h
+ *
+ * Small, fast, seedable pseudo random number generator for the game.
+ * This is a 16 bit xorshift generator (shifts 7, 9, 8) - it only needs
+ * shifts and exclusive-ors, unlike the avr-libc random() function which
+ * uses 32 bit multiplication and division. The period is 65535.
+ *
+ * The seed given to prng_seed() is remembered so that it can be reported
+ * (and a game reproduced by seeding with the same value).
+ */
+
+#ifndef PRNG_H_
+#define PRNG_H_
+
+#include <stdint.h>
+
+#include "isrstats.h"
+
+/* Seed the generator. A seed of 0 is not valid for xorshift generators
+ * so is replaced by a fixed non-zero value. prng_get_seed() will still
+ * return the value given here.
+ */
+void prng_seed(uint16_t seed);
+
+/* Return the seed most recently given to prng_seed() */
+uint16_t prng_get_seed(void);
+
+/* Return the next 16 bit pseudo random number */
+uint16_t prng_next(void);
+
+/* Return a pseudo random number from 0 to bound-1 inclusive. bound must
+ * be between 1 and 255. Every value in the range is equally likely
+ * (there is no modulo bias).
+ */
+uint8_t prng_below(uint8_t bound);
+
+/* Print the average number of CPU cycles per call of prng_next(),
+ * prng_below() and random() to the terminal. Does nothing unless the
+ * ISR_STATS instrumentation is compiled in (see isrstats.h) as this
+ * is what provides the cycle counter.
+ */
+#ifdef ISR_STATS
+void prng_benchmark(void);
+#else
+#define prng_benchmark()
+#endif
+
+#endif /* PRNG_H_ */
@@ -21,6 +21,17 @@
 #include "score.h"
 #include "timer0.h"
 #include "game.h"
+#include "isrstats.h"
+#include "prng.h"
+#include "replay.h"
+#include "effects.h"
+#include "compositor.h"
+#include "render.h"
+#include "display.h"
+#include "spi.h"
+#include "autopilot.h"
+#include "tickstats.h"
+#include "highspeed.h"
 
 #define F_CPU 8000000L
 #include <util/delay.h>
@@ -29,14 +40,22 @@
 // given here
 void initialise_hardware(void);
 void splash_screen(void);
+void spi_self_test(void);
 void new_game(void);
 void play_game(void);
 void handle_game_over(void);
+void use_display_backends(void);
 
-volatile int track_time =  0;
-volatile int FasterGame = 0;
-// ASCII code for Escape character
-#define ESCAPE_CHAR 27
+// Serial port baud rate. The terminal must be set to the same rate. 
+// 38400 or 76800 can be used to get terminal output out faster - see
+// init_serial_stdio() in serialio.h for the rates that can be used.
+#define SERIAL_BAUD_RATE 19200
+
+// Whether game output goes to the null display backend rather than the 
+// LED matrix and terminal (chosen with 'n' - see use_display_backends()),
+// and whether it currently does
+static uint8_t nullDisplayChosen;
+static uint8_t nullDisplayUsed;
 
 /////////////////////////////// main //////////////////////////////////
 int main(void) {
@@ -58,11 +77,19 @@ int main(void) {
 void initialise_hardware(void) {
 	ledmatrix_setup();
 	init_button_interrupts();
-	// Setup serial port for 19200 baud communication with no echo
-	// of incoming characters
-	init_serial_stdio(19200,0);
+	// Setup serial port for SERIAL_BAUD_RATE communication with no echo
+	// of incoming characters. If that rate can't be generated accurately
+	// enough we fall back to 19200 baud.
+	if(!init_serial_stdio(SERIAL_BAUD_RATE,0)) {
+		init_serial_stdio(19200,0);
+	}
 	
 	init_timer0();
+	isrstats_init();
+	
+	// Game output goes to the LED matrix and the terminal
+	display_add_backend(&led_matrix_backend);
+	display_add_backend(&terminal_backend);
 
 	
 
@@ -73,38 +100,129 @@ void initialise_hardware(void) {
 }
 
 void splash_screen(void) {
-	// Clear terminal screen and output a message
-	clear_terminal();
-	move_cursor(10,10);
-	printf_P(PSTR("Asteroids"));
-	move_cursor(10,12);
-	printf_P(PSTR("CSSE2010/7201 project by Nikhil Naik"));
-	move_cursor(10,14);
-	printf_P(PSTR("Score 0"));
+	// The message is rendered once and then scrolled repeatedly
+	uint8_t strip[8 * SCROLL_COLUMNS_PER_CHAR];
+	uint16_t strip_length = scroll_render_strip("45293858", strip, sizeof(strip));
+	uint8_t self_test = 0;
 	
-	// Output the scrolling message to the LED matrix
-	// and wait for a push button to be pushed.
-	ledmatrix_clear();
+	// We come back here after the SPI self test
 	while(1) {
-		set_scrolling_display_text("45293858", COLOUR_GREEN);
-		// Scroll the message until it has scrolled off the 
-		// display or a button is pushed
-		while(scroll_display()) {
-			_delay_ms(150);
+		// Clear terminal screen and output a message
+		clear_terminal();
+		move_cursor(10,10);
+		printf_P(PSTR("Asteroids"));
+		move_cursor(10,12);
+		printf_P(PSTR("CSSE2010/7201 project by Nikhil Naik"));
+		move_cursor(10,14);
+		printf_P(PSTR("Score 0"));
+		move_cursor(10,16);
+		printf_P(PSTR("Press s to test the LED matrix SPI speed"));
+	
+		// Output the scrolling message to the LED matrix
+		// and wait for a push button to be pushed.
+		ledmatrix_clear();
+		while(!self_test) {
+			// Scroll the message (one column every SCROLL_DEFAULT_PERIOD 
+			// milliseconds), starting it again each time it has scrolled
+			// off the display. We check the buttons in between.
+			if(!scroll_display_service(get_current_time())) {
+				scroll_display_queue_strip(strip, strip_length, COLOUR_GREEN, SCROLL_LEFT);
+			}
 			if(button_pushed() != NO_BUTTON_PUSHED) {
+				scroll_display_stop();
 				return;
 			}
+			if(serial_input_available()) {
+				char serial_input = fgetc(stdin);
+				self_test = (serial_input == 's' || serial_input == 'S');
+			}
 		}
+		scroll_display_stop();
+		spi_self_test();
+		self_test = 0;
+	}
+}
+
+// LED matrix SPI self test. Each SPI clock divider is tried in turn, from
+// the slowest to the fastest. The pattern the LED matrix should show is 
+// drawn on the terminal and the player types y if the LED matrix matches
+// it (anything else if not). We stop at the first divider that fails and
+// keep the fastest one that passed.
+void spi_self_test(void) {
+	static const uint8_t dividers[] PROGMEM = { 128, 64, 32, 16, 8, 4, 2 };
+	uint8_t divider;
+	uint8_t fastest = ledmatrix_get_spi_divider();
+	char answer;
+	
+	clear_terminal();
+	move_cursor(10,2);
+	printf_P(PSTR("LED matrix SPI self test - the LED matrix should show:"));
+	
+	// Top row of the LED matrix (y = 7) first
+	for(int8_t y = MATRIX_NUM_ROWS - 1; y >= 0; y--) {
+		move_cursor(10, 4 + (MATRIX_NUM_ROWS - 1 - y));
+		for(uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			PixelColour colour = ledmatrix_self_test_colour(x, y);
+			if(colour == COLOUR_GREEN) {
+				putchar('G');
+			} else if(colour == COLOUR_RED) {
+				putchar('R');
+			} else {
+				putchar('.');
+			}
+		}
+	}
+	
+	for(uint8_t i = 0; i < sizeof(dividers); i++) {
+		divider = pgm_read_byte(&dividers[i]);
+		ledmatrix_set_spi_divider(divider);
+		ledmatrix_self_test_pattern();
+		
+		move_cursor(10,14);
+		clear_to_end_of_line();
+		printf_P(PSTR("Clock divided by %u - does it match? (y/n) "), divider);
+		answer = fgetc(stdin);
+		if(answer != 'y' && answer != 'Y') {
+			break;
+		}
+		fastest = divider;
+	}
+	ledmatrix_set_spi_divider(fastest);
+	ledmatrix_clear();
+	
+	move_cursor(10,16);
+	printf_P(PSTR("Using SPI clock divided by %u"), fastest);
+	move_cursor(10,17);
+	printf_P(PSTR("(Set LEDMATRIX_SPI_DIVIDER in ledmatrix.h to keep this)"));
+	move_cursor(10,19);
+	printf_P(PSTR("Press a button to continue"));
+	while(button_pushed() == NO_BUTTON_PUSHED) {
+		; // wait
 	}
 }
 
 void new_game(void) {
+	// Seed the random number generator from the clock - the time 
+	// at which a button was pressed to start the game is unpredictable.
+	// The seed is shown on the terminal so the game can be reproduced.
+	// If we're replaying a game we use the recorded seed, otherwise we
+	// start recording this game.
+	if(replay_playing()) {
+		prng_seed(replay_seed());
+	} else {
+		prng_seed(get_current_time16());
+		replay_start_recording(prng_get_seed());
+	}
+
 	// Initialise the game and display
 
+	use_display_backends();
 	initialise_game();
 	
 	// Clear the serial terminal
 	clear_terminal();
+	move_cursor(TERMINAL_SCORE_X, TERMINAL_SEED_Y);
+	printf_P(PSTR("Seed %u"), prng_get_seed());
 	
 	// Initialise the score
 	init_score();
@@ -116,50 +234,87 @@ void new_game(void) {
 }
 
 void play_game(void) {
-	uint32_t current_time, last_move_time,asteroid_time;
+	uint32_t start_time, current_time;
 	int8_t button;
+	int8_t input;
 	char serial_input, escape_sequence_char;
-	uint8_t characters_into_escape_sequence = 0;
+	uint8_t escape_sequence_state = 0;
+	int16_t decoded_input;
 	int pauseGame = 0;
+	uint8_t replay_ran_out = 0;
 	
-		move_cursor(14,12);
-		printf_P(PSTR("Score %d\n"),get_score());
-		move_cursor(14,13);
-		printf_P(PSTR("Lives Remaining %d\n"),4);
+		// Show the playing field (on the LED matrix and the terminal), 
+		// score and lives
+		render_score(get_score());
+		render_lives(4);
+		render_drain();
 
-		hide_cursor();
-		move_cursor(53,19);
-		printf_P(PSTR("_|_"));
-		move_cursor(47,2);
-		printf_P(PSTR("################"));
-		move_cursor(47,20);
-		printf_P(PSTR("################"));
-		for(int i = 3; i < 20; i = i +1){
-			move_cursor(47,i);
-			printf_P(PSTR("#"));
-		}
-		for(int i = 3; i < 20; i = i +1){
-			move_cursor(62,i);
-			printf_P(PSTR("#"));
-		}
-
-	// Get the current time and remember this as the last time the projectiles
-    // were moved.
-	current_time = get_current_time();
-	last_move_time = current_time;
-	asteroid_time = current_time;
-	FasterGame = 0;
+	// Get the current time and remember this as the start of the game.
+	// Game time (current_time below) is measured from here - see the
+	// game clock in game.h
+	start_time = get_current_time();
+	current_time = 0;
+	start_game_clock();
+	autopilot_start_game();
+	highspeed_start_game();
 	if(is_game_over()){
-		FasterGame = 0;
 		button = button_pushed();
 		if(button){
-			//track_time = 0;
-			//current_time = get_current_time();
 			lifeLost(0);
 		}
 	}
 	// We play the game until it's over
 	while(!is_game_over()) {
+		// Time this tick (does nothing unless TICK_STATS is defined - see
+		// tickstats.h). A tick carries on through the passes that only
+		// move things.
+		tickstats_start_tick();
+		highspeed_start_tick();
+		if(replay_playing()) {
+			// We're replaying a recorded game - we don't wait for time to
+			// pass but jump straight to the next recorded input or the next
+			// move, whichever comes first. We stop if we get past the end of
+			// the recording (if it ran out of space, or the game didn't end
+			// when it should have).
+			if((replay_end_code() && 
+					(pauseGame || next_move_time() > replay_next_time())) ||
+					(pauseGame && replay_next_time() == REPLAY_NO_EVENT)) {
+				replay_ran_out = 1;
+				break;
+			}
+			if(!pauseGame && next_move_time() < replay_next_time()) {
+				if(next_move_time() > current_time) {
+					current_time = next_move_time();
+				}
+			} else if(replay_next_time() > current_time) {
+				current_time = replay_next_time();
+			}
+		} else if(autopilot_mode() == AUTOPILOT_MAX_SPEED && !pauseGame) {
+			// The autopilot is playing as fast as it can - as for a replay
+			// we jump straight to the next move or autopilot decision,
+			// whichever comes first. start_time is kept in step so that 
+			// the game can carry on in real time.
+			if(next_move_time() < autopilot_next_time()) {
+				if(next_move_time() > current_time) {
+					current_time = next_move_time();
+				}
+			} else if(autopilot_next_time() > current_time) {
+				current_time = autopilot_next_time();
+			}
+			start_time = get_current_time() - current_time;
+		} else {
+			current_time = get_current_time() - start_time;
+		}
+		
+		// Move the projectiles and/or asteroids if it's time to. If something
+		// moved we go around again (checking if the game is over) so that
+		// everything that is due has moved before we deal with any input.
+		if(!pauseGame && advance_game(current_time)) {
+			continue;
+		}
+		
+		// Move any visual effects (e.g. the base flashing) along
+		effects_update(current_time);
 		
 		// Check for input - which could be a button push or serial input.
 		// Serial input may be part of an escape sequence, e.g. ESC [ D
@@ -169,153 +324,194 @@ void play_game(void) {
 		// if no button pushes are waiting to be returned.)
 		// Button pushes take priority over serial input. If there are both then
 		// we'll retrieve the serial input the next time through this loop
+		// When replaying, the input comes from the recording instead.
+		TICK_STATS_BEGIN();
 		serial_input = -1;
 		escape_sequence_char = -1;
-		button = button_pushed();
+		input = INPUT_NONE;
+		button = NO_BUTTON_PUSHED;
+		if(replay_playing()) {
+			input = replay_next_input(current_time);
+		} else {
+			button = button_pushed();
+		}
 		
-		if(button == NO_BUTTON_PUSHED) {
+		if(button == NO_BUTTON_PUSHED && !replay_playing()) {
 			// No push button was pushed, see if there is any serial input
 			if(serial_input_available()) {
 				// Serial data was available - read the data from standard input
-				serial_input = fgetc(stdin);
-				// Check if the character is part of an escape sequence
-				if(characters_into_escape_sequence == 0 && serial_input == ESCAPE_CHAR) {
-					// We've hit the first character in an escape sequence (escape)
-					characters_into_escape_sequence++;
-					serial_input = -1; // Don't further process this character
-				} else if(characters_into_escape_sequence == 1 && serial_input == '[') {
-					// We've hit the second character in an escape sequence
-					characters_into_escape_sequence++;
-					serial_input = -1; // Don't further process this character
-				} else if(characters_into_escape_sequence == 2) {
+				// and check if the character is part of an escape sequence
+				decoded_input = decode_terminal_input(&escape_sequence_state,
+						fgetc(stdin));
+				if(IS_TERMINAL_KEY(decoded_input)) {
 					// Third (and last) character in the escape sequence
-					escape_sequence_char = serial_input;
-					serial_input = -1;  // Don't further process this character - we
-										// deal with it as part of the escape sequence
-					characters_into_escape_sequence = 0;
-				} else {
-					// Character was not part of an escape sequence (or we received
-					// an invalid second character in the sequence). We'll process 
-					// the data in the serial_input variable.
-					characters_into_escape_sequence = 0;
+					escape_sequence_char = decoded_input & 0xFF;
+				} else if(decoded_input != TERMINAL_INPUT_NONE) {
+					// Character was not part of an escape sequence - we'll 
+					// process the data in the serial_input variable.
+					serial_input = decoded_input;
 				}
 			}
 		}
 		
-		if(!pauseGame){// Process the input. 
+		// Work out what the input means
 		if(button==3 || escape_sequence_char=='D' || serial_input=='L' || serial_input=='l') {
 			// Button 3 pressed OR left cursor key escape sequence completed OR
 			// letter L (lowercase or uppercase) pressed - attempt to move left
-			move_base(MOVE_LEFT);
+			input = INPUT_LEFT;
 		} else if(button==2 || escape_sequence_char=='A' || serial_input==' ') {
 			// Button 2 pressed or up cursor key escape sequence completed OR
 			// space bar pressed - attempt to fire projectile
-			fire_projectile();
-		} else if(button==1 || escape_sequence_char=='B') {
-			// Button 1 pressed OR down cursor key escape sequence completed
-			// Ignore at present
+			input = INPUT_FIRE;
+		} else if(button==1 || serial_input == 'p' || serial_input == 'P') {
+			// Button 1 pressed OR letter P (lowercase or uppercase) pressed -
+			// pause/unpause the game
+			input = INPUT_PAUSE;
 		} else if(button==0 || escape_sequence_char=='C' || serial_input=='R' || serial_input=='r') {
 			// Button 0 pressed OR right cursor key escape sequence completed OR
 			// letter R (lowercase or uppercase) pressed - attempt to move right
-			move_base(MOVE_RIGHT);
+			input = INPUT_RIGHT;
 		} 
-			// Unimplemented feature - pause/unpause the game until 'p' or 'P' is
-			// pressed again
-			// need to have two toogles twice and stop from entering if else for astroids
-			//and projectiles
-			//int toogle = 0;
-			//while(toogle == 0){
-				//if(button == 1){
-					//while(button == 1){
-					//do nothing	
-					//}
-					//while(button == 0){
-					//do nothing 
-					//}
-					//if(button == 1){
-						//toogle = 1;
-					//}
-				//}
-			//}
-			//toogle = 0 make this volatile
-			//if(!paused){
-			//paused = 1;
-			//pause_time = get_current_time()
-			//}else{pause_time = get_current_time() - pause time
-			//current_time -= timePaused
-			//paused}
-			
+		// else - invalid input or we're part way through an escape sequence -
+		// nothing to do (down cursor key is ignored at present)
+		
+		// Switch high speed mode on or off (or hold the speed) if we need
+		// to - see highspeed.h
+		if(input == INPUT_NONE && !replay_playing()) {
+			input = highspeed_next_input();
+		}
 		
+		// If the autopilot is on it plays when nobody else has
+		if(input == INPUT_NONE && autopilot_mode() != AUTOPILOT_OFF &&
+				!replay_playing()) {
+			input = autopilot_next_input(current_time);
+		}
 		
+		// Moving and firing are ignored while the game is paused. We
+		// only record the inputs that have an effect.
+		if(pauseGame && input != INPUT_PAUSE) {
+			input = INPUT_NONE;
+		}
+		if(!replay_playing()) {
+			replay_record_input(current_time, input);
 		}
-		if(button==1 || serial_input == 'p' || serial_input == 'P') {
+		
+		// Process the input
+		if(input == INPUT_LEFT) {
+			move_base(MOVE_LEFT);
+		} else if(input == INPUT_FIRE) {
+			fire_projectile();
+		} else if(input == INPUT_RIGHT) {
+			move_base(MOVE_RIGHT);
+		} else if(input == INPUT_PAUSE) {
 			if(pauseGame){
 			//reset
-			clear_terminal();
+			render_message(PSTR(""));
 			pauseGame = 0;
+			resume_game_clock(current_time);
 			}else{
 				pauseGame = 1;
-				move_cursor(10,2);
-				printf_P(PSTR("PAUSED"));
-				move_cursor(10,3);
-				printf_P(PSTR("PRESS P OR p TO RESUME"));
+				pause_game_clock(current_time);
+				render_message(PSTR("PAUSED - PRESS P OR p TO RESUME"));
+			}
+		} else if(input == INPUT_HIGH_SPEED) {
+			toggle_high_speed();
+			if(high_speed()) {
+				render_message(PSTR("HIGH SPEED"));
+			} else {
+				render_message(PSTR(""));
 			}
+		} else if(input == INPUT_HOLD_SPEED) {
+			hold_speed();
+			render_message(PSTR("HIGH SPEED - HELD AT THIS SPEED"));
 		}
-		// else - invalid input or we're part way through an escape sequence -
-		// do nothing
-				hide_cursor();
-				move_cursor(47,2);
-		printf_P(PSTR("################"));
-				move_cursor(47,20);
-		printf_P(PSTR("################"));
-				for(int i = 3; i < 20; i = i +1){
-					move_cursor(47,i);
-					printf_P(PSTR("#"));
-				}
-				for(int i = 3; i < 20; i = i +1){
-					move_cursor(62,i);
-					printf_P(PSTR("#"));
-				}
-		current_time = get_current_time();
-		if(!is_game_over() && current_time >= last_move_time + 500 && !pauseGame) {
-			// 500ms (0.5 second) has passed since the last time we moved
-			// the projectiles - move them - and keep track of the time we 
-			// moved them
-
-			advance_projectiles();
-			
-			last_move_time = current_time;
+		TICK_STATS_END(TICK_PHASE_INPUT);
+		
+		// The statistics and dumps below take far longer than a tick so
+		// the tick they're in isn't counted
+		if(serial_input == 'i' || serial_input == 'I') {
+			// Show the interrupt latency statistics (does nothing unless
+			// ISR_STATS is defined - see isrstats.h)
+			isrstats_print();
+			tickstats_discard_tick();
 		}
-		//if(!is_game_over() && current_time >= asteroid_time + 250 && track_time <40) {
-			// 500ms (0.5 second) has passed since the last time we moved
-			// the projectiles - move them - and keep track of the time we
-			// moved them
-			//int track_time =  0;
-			//advance_falling_astroid();
-			//track_time = track_time + 1;
-			//asteroid_time = current_time;
-		//}
-		if(!is_game_over() && current_time >= asteroid_time + 500 - FasterGame && !pauseGame){ //&& track_time >=40) {
-			// 500ms (0.5 second) has passed since the last time we moved
-			// the projectiles - move them - and keep track of the time we
-			//printf_P(PSTR("Faster Game value %d\n"),FasterGame);
-			if(get_score() >10&& FasterGame <400){
-				FasterGame = FasterGame + 10;
-			}
-			if(FasterGame > 100){
-				FasterGame = 200;
+		if(serial_input == 'b' || serial_input == 'B') {
+			// Compare the cost of our random number generator with
+			// random() (does nothing unless ISR_STATS is defined)
+			prng_benchmark();
+			tickstats_discard_tick();
+		}
+		if(serial_input == 'c' || serial_input == 'C') {
+			// Send the most recent LED matrix SPI bytes (does nothing 
+			// unless SPI_CAPTURE is defined - see spi.h)
+			spi_capture_dump();
+			tickstats_discard_tick();
+		}
+		if(serial_input == 'w' || serial_input == 'W') {
+			// Show the worst case tick timings (does nothing unless
+			// TICK_STATS is defined)
+			tickstats_print();
+		}
+		if(serial_input == 'n' || serial_input == 'N') {
+			// Send the next game's output to the null display backend 
+			// (or not) - to time the game without any display cost
+			nullDisplayChosen = !nullDisplayChosen;
+		}
+		if(serial_input == 'h' || serial_input == 'H') {
+			// Choose high speed mode (or not) for this game and the next
+			highspeed_choose(!highspeed_chosen());
+		}
+		if(serial_input == 'a' || serial_input == 'A') {
+			// Autopilot off -> real time -> maximum speed -> off
+			if(autopilot_mode() == AUTOPILOT_OFF) {
+				autopilot_set_mode(AUTOPILOT_REAL_TIME);
+				render_message(PSTR("AUTOPILOT"));
+			} else if(autopilot_mode() == AUTOPILOT_REAL_TIME) {
+				autopilot_set_mode(AUTOPILOT_MAX_SPEED);
+				render_message(PSTR("AUTOPILOT - MAXIMUM SPEED"));
+			} else {
+				autopilot_set_mode(AUTOPILOT_OFF);
+				render_message(PSTR(""));
 			}
-			// moved them
-			//int track_time =  0;
-			advance_falling_astroid();
-			//track_time = track_time + 1;
-			asteroid_time = current_time;
 		}
+		
+		// Show the results of this time around the loop (moves, effects and
+		// input) - only LED matrix cells that changed are sent
+		compositor_flush();
+		render_drain();
+		tickstats_end_tick();
+		highspeed_end_tick();
+	}
+	// We get here if the game is over (or a replay has run out).
+	compositor_flush();
+	render_drain();
+	tickstats_end_tick();
+	highspeed_end_tick();
+	if(!replay_ran_out) {
+		replay_game_over(last_move_time());
+	}
+	if(replay_playing()) {
+		move_cursor(10,17);
+		if(replay_matched()) {
+			printf_P(PSTR("Replay matched the recording"));
+		} else if(replay_end_code() == REPLAY_END_TRUNCATED) {
+			printf_P(PSTR("Replay stopped (recording was full)"));
+		} else {
+			printf_P(PSTR("Replay did not match the recording"));
+		}
+		replay_stop_playback();
 	}
-	// We get here if the game is over.
 }
 
 void handle_game_over() {
+	uint32_t game_over_time;
+	
+	// The playing field stays on the terminal but no longer scrolls
+	enable_scrolling_for_whole_display();
+	if(autopilot_mode() != AUTOPILOT_OFF) {
+		autopilot_game_over(get_score(), last_move_time());
+		autopilot_print_stats();
+	}
 	move_cursor(10,15);
 	printf_P(PSTR("GAME OVER"));
 	move_cursor(10,16);
@@ -323,19 +519,64 @@ void handle_game_over() {
 	ledmatrix_clear();
 	//set_scrolling_display_text("GAME OVER",COLOUR_ORANGE);
 
-	animation();
-
-	ledmatrix_clear();
-	//ledmatrix_clear();
-	
-	
-
-	//ledmatrix_clear();
-
-
+	// (Kept short so it doesn't run into the playing field)
+	move_cursor(10,18);
+	printf_P(PSTR("Press d to send the recording"));
+	move_cursor(10,19);
+	printf_P(PSTR("Press r to replay this game"));
 
+	// Run the game over animation while we wait. Pressing a button skips
+	// the rest of it.
+	game_over_time = get_current_time();
+	start_game_over_animation(game_over_time);
 	while(button_pushed() == NO_BUTTON_PUSHED) {
-		; // wait
+		// The autopilot starts the next game by itself
+		if(autopilot_mode() == AUTOPILOT_MAX_SPEED ||
+				(autopilot_mode() == AUTOPILOT_REAL_TIME && get_current_time() -
+				game_over_time >= AUTOPILOT_RESTART_DELAY)) {
+			return;
+		}
+		update_game_over_animation(get_current_time());
+		if(serial_input_available()) {
+			char serial_input = fgetc(stdin);
+			if(serial_input == 'd' || serial_input == 'D') {
+				replay_dump();
+			} else if(serial_input == 'c' || serial_input == 'C') {
+				spi_capture_dump();
+			} else if(serial_input == 'w' || serial_input == 'W') {
+				tickstats_print();
+			} else if(serial_input == 'n' || serial_input == 'N') {
+				nullDisplayChosen = !nullDisplayChosen;
+			} else if(serial_input == 'a' || serial_input == 'A') {
+				// Stop the autopilot (e.g. to send its last recording)
+				autopilot_set_mode(AUTOPILOT_OFF);
+			} else if(serial_input == 'r' || serial_input == 'R') {
+				// The next game will be a replay of the recording (if 
+				// it's all still here)
+				if(replay_start_playback()) {
+					return;
+				}
+				move_cursor(10,20);
+				printf_P(PSTR("Too long to replay here"));
+			}
+		}
 	}
 	
 }
+
+// Switch the game output between the LED matrix and terminal backends and
+// the null backend (see display.h) if 'n' has changed the choice. This
+// is only done at the start of a game, which redraws the whole display.
+void use_display_backends(void) {
+	if(nullDisplayChosen == nullDisplayUsed) {
+		return;
+	}
+	nullDisplayUsed = nullDisplayChosen;
+	display_remove_backends();
+	if(nullDisplayUsed) {
+		display_add_backend(&null_backend);
+	} else {
+		display_add_backend(&led_matrix_backend);
+		display_add_backend(&terminal_backend);
+	}
+}
@@ -0,0 +1,77 @@
+/*
+ * render.c
+ *
+ * Render command list - see render.h
+ */
+
+#include "render.h"
+#include "display.h"
+
+static RenderCommand commands[RENDER_LIST_SIZE];
+static uint8_t numCommands = 0;
+static RenderConsumer consumer = display_render_command;
+
+// Pass each command in the list to the consumer and empty the list
+static void pass_commands(void) {
+	for(uint8_t i = 0; i < numCommands; i++) {
+		consumer(&commands[i]);
+	}
+	numCommands = 0;
+}
+
+// Return the next free command in the list, passing on the commands 
+// already in the list first if it's full
+static RenderCommand* new_command(uint8_t type) {
+	RenderCommand* command;
+	
+	if(numCommands == RENDER_LIST_SIZE) {
+		pass_commands();
+	}
+	command = &commands[numCommands++];
+	command->type = type;
+	return command;
+}
+
+void render_cell(uint8_t x, uint8_t y, PixelColour colour) {
+	RenderCommand* command = new_command(RENDER_CELL);
+	command->cell.x = x;
+	command->cell.y = y;
+	command->cell.colour = colour;
+}
+
+// Return the command of the given type already in the list, or a new 
+// one if there isn't one. This is used for values (like the score) where
+// only the latest value matters.
+static RenderCommand* replace_command(uint8_t type) {
+	for(uint8_t i = 0; i < numCommands; i++) {
+		if(commands[i].type == type) {
+			return &commands[i];
+		}
+	}
+	return new_command(type);
+}
+
+void render_score(uint16_t score) {
+	replace_command(RENDER_SCORE)->value = score;
+}
+
+void render_lives(uint8_t lives) {
+	replace_command(RENDER_LIVES)->value = lives;
+}
+
+void render_message(const char* message) {
+	new_command(RENDER_MESSAGE)->message = message;
+}
+
+void render_clear(void) {
+	new_command(RENDER_CLEAR);
+}
+
+void render_drain(void) {
+	new_command(RENDER_END_FRAME);
+	pass_commands();
+}
+
+void render_set_consumer(RenderConsumer newConsumer) {
+	consumer = newConsumer;
+}
@@ -0,0 +1,74 @@
+/*
+ * render.h
+ *
+ * Render command list. Rather than writing to the LED matrix and the 
+ * terminal as it goes, the game adds commands describing what has 
+ * changed (a cell, the score, the number of lives, a message) to a list.
+ * The list is drained - each command passed in order to the current 
+ * consumer - once per time around the main loop, after the game has 
+ * done its work. This keeps the cost of the game logic separate from
+ * the cost of output, and lets the consumer decide what to do with the 
+ * output (e.g. send it to the display, or throw it away when measuring
+ * how long the game logic takes).
+ */
+
+#ifndef RENDER_H_
+#define RENDER_H_
+
+#include <stdint.h>
+#include "pixel_colour.h"
+
+// Command types
+#define RENDER_CELL		0	// LED matrix cell changed colour
+#define RENDER_SCORE	1	// score changed
+#define RENDER_LIVES	2	// number of lives changed
+#define RENDER_MESSAGE	3	// message to the player (program memory string)
+#define RENDER_CLEAR	4	// whole display cleared (all cells black)
+#define RENDER_END_FRAME 5	// end of this time around the main loop
+
+typedef struct {
+	uint8_t type;
+	union {
+		struct {
+			uint8_t x;
+			uint8_t y;
+			PixelColour colour;
+		} cell;
+		uint16_t value;
+		const char* message;
+	};
+} RenderCommand;
+
+// Maximum number of commands in the list. If the list fills up it is
+// drained early.
+#define RENDER_LIST_SIZE 32
+
+// Add commands to the list. Cell coordinates are LED matrix x (0 to 15)
+// and y (0 to 7). The message string must be in program memory, e.g. 
+// render_message(PSTR("PAUSED")), and no more than 32 characters long.
+// An empty message clears the message.
+// If the score or lives are changed more than once before the list is
+// drained, only the latest value is kept.
+void render_cell(uint8_t x, uint8_t y, PixelColour colour);
+void render_score(uint16_t score);
+void render_lives(uint8_t lives);
+void render_message(const char* message);
+
+// Clear the whole display. Cells are then black until changed by 
+// render_cell().
+void render_clear(void);
+
+// Pass each command in the list, in order, to the consumer and empty
+// the list. A RENDER_END_FRAME command is passed last, so that a consumer
+// can put off work until it has seen all of the changes for the frame.
+// (Commands passed early because the list filled up aren't followed by
+// RENDER_END_FRAME.)
+void render_drain(void);
+
+// Set the function that render_drain() passes commands to. The default
+// is display_render_command(), which passes them on to the display
+// backends (see display.h).
+typedef void (*RenderConsumer)(const RenderCommand* command);
+void render_set_consumer(RenderConsumer consumer);
+
+#endif /* RENDER_H_ */
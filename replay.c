@@ -0,0 +1,226 @@
+/*
+ * replay.c
+ *
+ * Recording and replay of games - see replay.h for the recording format.
+ */
+
+#include <stdint.h>
+
+#include "replay.h"
+#include "game.h"
+#include "serialio.h"
+
+// Size of the version, seed and part number at the start of each part,
+// and where the part number is
+#define HEADER_SIZE 4
+#define PART_POS 3
+
+// Most bytes an event can take. (A 32 bit time shifted left by 3 bits
+// needs at most 5 bytes.)
+#define MAX_EVENT_BYTES 5
+
+// Space kept free so that an end event can always be added
+#define END_EVENT_SPACE MAX_EVENT_BYTES
+
+// The part of the recording being recorded and the number of bytes of 
+// it in use
+static uint8_t replay_buffer[REPLAY_BUFFER_SIZE];
+static uint16_t replay_length;
+
+// The recording being replayed - replay_buffer, or a whole recording 
+// given to replay_load()
+static const uint8_t* play_data = replay_buffer;
+static uint16_t play_length;
+
+// Whether we are recording or playing back, and whether the replay
+// finished the same way as the recording
+static uint8_t recording;
+static uint8_t playing;
+static uint8_t matched;
+
+// Game time of the last event recorded or replayed
+static uint32_t last_event_time;
+
+// Playback position - the next event (already decoded) is next_event_code
+// at game time next_event_time, and the event after it starts at read_pos.
+static uint16_t read_pos;
+static uint32_t next_event_time;
+static uint8_t next_event_code;
+
+static void write_event(uint32_t time, uint8_t code) {
+	uint32_t value = ((time - last_event_time) << 3) | code;
+	last_event_time = time;
+
+	// Output 7 bits at a time, least significant first. The top bit
+	// is set if there are more bytes to come.
+	while(value >= 0x80) {
+		replay_buffer[replay_length++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	replay_buffer[replay_length++] = value;
+}
+
+static void record_event(uint32_t time, uint8_t code) {
+	uint32_t value;
+	uint8_t bytes_needed;
+
+	if(!recording) {
+		return;
+	}
+
+	if(code == REPLAY_END_GAME_OVER) {
+		write_event(time, code);
+		recording = 0;
+		return;
+	}
+
+	// Work out how much space the event will need. If there isn't room
+	// (leaving space for an end event) we stop recording.
+	value = ((time - last_event_time) << 3) | code;
+	bytes_needed = 1;
+	while(value >= 0x80) {
+		value >>= 7;
+		bytes_needed++;
+	}
+	if(replay_length + bytes_needed > REPLAY_BUFFER_SIZE - END_EVENT_SPACE) {
+		if(replay_buffer[PART_POS] == 0xFF) {
+			// No part numbers left
+			write_event(time, REPLAY_END_TRUNCATED);
+			recording = 0;
+			return;
+		}
+		// Send this part and carry on in the next one
+		replay_dump();
+		replay_buffer[PART_POS]++;
+		replay_length = HEADER_SIZE;
+	}
+	write_event(time, code);
+}
+
+// Decode the event at read_pos into next_event_time and next_event_code
+static void read_next_event(void) {
+	uint32_t value = 0;
+	uint8_t shift = 0;
+	uint8_t bytes = 0;
+	uint8_t byte;
+
+	do {
+		if(read_pos >= play_length || bytes == MAX_EVENT_BYTES) {
+			// Nothing more recorded, or the event is cut off or too long
+			// (so the recording is corrupt) - stop here
+			read_pos = play_length;
+			next_event_time = REPLAY_NO_EVENT;
+			next_event_code = 0;
+			return;
+		}
+		byte = play_data[read_pos++];
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		shift += 7;
+		bytes++;
+	} while(byte & 0x80);
+
+	next_event_code = value & 0x07;
+	next_event_time = last_event_time + (value >> 3);
+	last_event_time = next_event_time;
+}
+
+void replay_start_recording(uint16_t seed) {
+	replay_buffer[0] = REPLAY_VERSION;
+	replay_buffer[1] = seed & 0xFF;
+	replay_buffer[2] = seed >> 8;
+	replay_buffer[PART_POS] = 0;
+	replay_length = HEADER_SIZE;
+	play_data = replay_buffer;
+	last_event_time = 0;
+	recording = 1;
+}
+
+void replay_record_input(uint32_t time, int8_t input) {
+	if(input != INPUT_NONE) {
+		record_event(time, input);
+	}
+}
+
+void replay_game_over(uint32_t time) {
+	if(playing) {
+		matched = (next_event_code == REPLAY_END_GAME_OVER &&
+				next_event_time == time);
+	} else {
+		record_event(time, REPLAY_END_GAME_OVER);
+	}
+}
+
+uint8_t replay_matched(void) {
+	return matched;
+}
+
+void replay_dump(void) {
+	if(replay_length >= HEADER_SIZE) {
+		serial_write_frame(SERIAL_FRAME_REPLAY, replay_buffer, replay_length);
+	}
+}
+
+uint8_t replay_load(const uint8_t* data, uint16_t length) {
+	if(length < HEADER_SIZE || data[0] != REPLAY_VERSION || 
+			data[PART_POS] != 0) {
+		return 0;
+	}
+	play_data = data;
+	play_length = length;
+	recording = 0;
+	return 1;
+}
+
+uint8_t replay_start_playback(void) {
+	if(play_data == replay_buffer) {
+		if(replay_length < HEADER_SIZE || replay_buffer[PART_POS] != 0) {
+			// Nothing has been recorded, or only the last part of the 
+			// recording is still here
+			return 0;
+		}
+		play_length = replay_length;
+	}
+	recording = 0;
+	playing = 1;
+	matched = 0;
+	read_pos = HEADER_SIZE;
+	last_event_time = 0;
+	read_next_event();
+	return 1;
+}
+
+void replay_stop_playback(void) {
+	playing = 0;
+}
+
+uint8_t replay_playing(void) {
+	return playing;
+}
+
+uint16_t replay_seed(void) {
+	return play_data[1] | (play_data[2] << 8);
+}
+
+uint32_t replay_next_time(void) {
+	return next_event_time;
+}
+
+int8_t replay_next_input(uint32_t now) {
+	int8_t input;
+
+	if(next_event_time == REPLAY_NO_EVENT || next_event_time > now ||
+			next_event_code >= REPLAY_END_TRUNCATED) {
+		return INPUT_NONE;
+	}
+	input = next_event_code;
+	read_next_event();
+	return input;
+}
+
+uint8_t replay_end_code(void) {
+	if(next_event_time != REPLAY_NO_EVENT && 
+			next_event_code >= REPLAY_END_TRUNCATED) {
+		return next_event_code;
+	}
+	return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * replay.h
+ *
+ * Recording and replay of games. While a game is played we record the
+ * random number seed and every game input (see INPUT_... in game.h)
+ * along with the game time at which it was dealt with. Since the game
+ * clock (see game.h) makes the game depend only on these, replaying the
+ * recording reproduces the game exactly. A replay doesn't wait for time
+ * to pass - it jumps straight to the next input or move - so it runs
+ * faster than real time.
+ *
+ * The recording is kept in RAM (REPLAY_BUFFER_SIZE bytes) and is sent 
+ * over the serial port (as SERIAL_FRAME_REPLAY frames - see serialio.h) 
+ * to be replayed by the host build (see host/headless.c). A whole game
+ * doesn't fit in RAM (the autopilot, which is about as quick as a person,
+ * records about 20 bytes a second), so it is recorded in parts. Each time
+ * the buffer fills up, the part in it is sent and recording carries on in
+ * a new part. The last part is sent by replay_dump() ('d' at the game 
+ * over screen). So the serial output has to be logged for the whole game
+ * to get the whole recording. The host joins the parts back together. 
+ * Sending a part puts about 200 bytes in the serial output buffer, which
+ * holds up the terminal output (for about 100ms at 19200 baud) but not
+ * the game - its inputs are recorded with the game time.
+ *
+ * Recording format (all multi-byte values are little endian):
+ *     version (REPLAY_VERSION), seed (2 bytes), part number, events ...
+ * Parts are numbered from 0. The events in each part carry on from the
+ * part before it, so a whole recording is part 0 followed by the events
+ * of each of the later parts in turn.
+ * Each event is a variable length number (7 bits per byte, least
+ * significant first, top bit set on all but the last byte) holding
+ *     (game time since previous event << 3) | event code
+ * where the event code is one of the INPUT_... values or one of the
+ * REPLAY_END_... values below. Most events fit in 2 bytes, and none
+ * take more than 5. An event that runs on past 5 bytes (or past the end
+ * of the recording) means the recording is corrupt - a replay stops
+ * there as if the recording had no end event, so it never matches.
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdint.h>
+
+#define REPLAY_VERSION 2
+
+// Size of each part of a recording (bytes) - this much RAM is used. If a
+// game needs more than 255 parts (about 48K bytes), recording stops and a
+// replay will stop at the same point.
+#ifndef REPLAY_BUFFER_SIZE
+#define REPLAY_BUFFER_SIZE 192
+#endif
+
+// Event codes which end a recording (the INPUT_... values must all be
+// lower). REPLAY_END_GAME_OVER is recorded with the time of the move that
+// ended the game. REPLAY_END_TRUNCATED is recorded if we run out of parts.
+#define REPLAY_END_TRUNCATED	6
+#define REPLAY_END_GAME_OVER	7
+
+// Start a new recording for a game using the given seed
+void replay_start_recording(uint16_t seed);
+
+// Record an input that was dealt with at the given game time
+void replay_record_input(uint32_t time, int8_t input);
+
+// Called when the game is over with the game time of the move that ended
+// it. When recording, this is recorded. When replaying, it's checked
+// against the recording - see replay_matched().
+void replay_game_over(uint32_t time);
+
+// Returns 1 if the replay reached game over at the same time as the 
+// recorded game did, 0 otherwise (including if it hasn't got there yet)
+uint8_t replay_matched(void);
+
+// Send the part of the recording in RAM over the serial port
+void replay_dump(void);
+
+// Replay the given whole recording (e.g. read from a file and joined 
+// together by the host build) rather than the one in RAM. The data must
+// be left as it is until the replay is over. Returns 1 if it looks like
+// a valid recording, 0 otherwise.
+uint8_t replay_load(const uint8_t* data, uint16_t length);
+
+// Start and stop replaying the recording. Nothing is recorded while
+// replaying. replay_start_playback() returns 0 (and doesn't start) if
+// there's no whole recording to replay - nothing has been recorded, or
+// the game was long enough that earlier parts have been sent and only 
+// the last part is still in RAM.
+uint8_t replay_start_playback(void);
+void replay_stop_playback(void);
+uint8_t replay_playing(void);
+
+// Seed of the recorded game
+uint16_t replay_seed(void);
+
+// Game time of the next recorded event (REPLAY_NO_EVENT if there is 
+// nothing more in the recording)
+#define REPLAY_NO_EVENT 0xFFFFFFFF
+uint32_t replay_next_time(void);
+
+// If the next recorded input is due at or before the given game time
+// then remove it from the recording and return it. Otherwise (or if the
+// next event is an end event) return INPUT_NONE.
+int8_t replay_next_input(uint32_t now);
+
+// Return the end event code if the next event is an end event (i.e. all
+// inputs have been replayed), 0 otherwise
+uint8_t replay_end_code(void);
+
+#endif /* REPLAY_H_ */
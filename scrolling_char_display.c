@@ -5,11 +5,13 @@
  *
  * This is an example of how the LED display board can be used. 
  * This program scrolls a message from right to left on the
- * board. The font used is defined below and is 7 dots high and
- * varies between 3 and 5 dots wide, depending on the character.
- * Letters and numbers can be handled (though lower case
- * letters are displayed as upper case). All other characters
- * display as a blank column.
+ * board. The font used is defined in font.h (see below) and is 7
+ * dots high and varies between 1 and 5 dots wide, depending on the
+ * character. Letters, numbers and some punctuation can be handled
+ * (though lower case letters are displayed as upper case). All other 
+ * characters display as a blank column. Messages can also be rendered
+ * once into a strip of columns and then scrolled (in either direction)
+ * without going back to the font - see scrolling_char_display.h.
  * 
  * The program also demonstrates how data can be stored in the
  * program (flash) memory, without also taking up space in RAM.
@@ -29,14 +31,11 @@
 
 /* FONT DEFINITION
  *
- * The following define the columns of data to be displayed
- * for each character (a-z and 0-9). The most significant
- * 7 bits (bit 7 to bit 1) represent the data for rows 7 to 1 
- * (top to bottom). The least significant bit is 1 only for
- * the last column of letter data. (This is how the software
- * will know when it has reached the last column for this 
- * character. We do not display data for this bit, i.e. 
- * row y=0 on the display will always be blank.
+ * The font is generated from host/font.txt by host/fontgen.c - see 
+ * there for the layout. Each column of a character is one byte. The 
+ * most significant 7 bits (bit 7 to bit 1) represent the data for 
+ * rows 7 to 1 (top to bottom). We do not display data for the least
+ * significant bit, i.e. row y=0 on the display will always be blank.
  * As an example, the data for the 4 columns of letter A is as 
  * follows:
  * bit 7  ** 
@@ -46,94 +45,176 @@
  * bit 3 *  *
  * bit 2 *  *
  * bit 1 *  *
- * bit 0    *
+ * bit 0     
  */
-
-/* Data for letters A-Z */
-static const uint8_t cols_A[] PROGMEM = {126, 144, 144, 127};
-static const uint8_t cols_B[] PROGMEM = {254, 146, 146, 109};
-static const uint8_t cols_C[] PROGMEM = {124, 130, 130, 69};
-static const uint8_t cols_D[] PROGMEM = {254, 130, 130, 125};
-static const uint8_t cols_E[] PROGMEM = {254, 146, 146, 131};
-static const uint8_t cols_F[] PROGMEM = {254, 144, 144, 129};
-static const uint8_t cols_G[] PROGMEM = {124, 130, 146, 93};
-static const uint8_t cols_H[] PROGMEM = {254, 16, 16, 255};
-static const uint8_t cols_I[] PROGMEM = {130, 254, 131};
-static const uint8_t cols_J[] PROGMEM = {4, 2, 2, 253};
-static const uint8_t cols_K[] PROGMEM = {254, 16, 40, 199};
-static const uint8_t cols_L[] PROGMEM = {254, 2, 2, 3};
-static const uint8_t cols_M[] PROGMEM = {254, 64, 48, 64, 255};
-static const uint8_t cols_N[] PROGMEM = {254, 32, 16, 255};
-static const uint8_t cols_O[] PROGMEM = {124, 130, 130, 125};
-static const uint8_t cols_P[] PROGMEM = {254, 144, 144, 97};
-static const uint8_t cols_Q[] PROGMEM = {124, 130, 138, 124, 3};
-static const uint8_t cols_R[] PROGMEM = {254, 144, 152, 103};
-static const uint8_t cols_S[] PROGMEM = {100, 146, 146, 77};
-static const uint8_t cols_T[] PROGMEM = {128, 128, 254, 128, 129};
-static const uint8_t cols_U[] PROGMEM = {252, 2, 2, 253};
-static const uint8_t cols_V[] PROGMEM = {248, 4, 2, 4, 249};
-static const uint8_t cols_W[] PROGMEM = {252, 2, 28, 2, 253};
-static const uint8_t cols_X[] PROGMEM = {198, 40, 16, 40, 199};
-static const uint8_t cols_Y[] PROGMEM = {224, 16, 14, 16, 225};
-static const uint8_t cols_Z[] PROGMEM = {134, 138, 146, 162, 195};
-
-/* Data for numbers 0 to 9 */
-static const uint8_t cols_0[] PROGMEM = {124, 146, 162, 125};
-static const uint8_t cols_1[] PROGMEM = {66, 254, 3};
-static const uint8_t cols_2[] PROGMEM = {70, 138, 146, 99};
-static const uint8_t cols_3[] PROGMEM = {68, 146, 146, 109};
-static const uint8_t cols_4[] PROGMEM = {24, 40, 72, 255};
-static const uint8_t cols_5[] PROGMEM = {228, 162, 162, 157};
-static const uint8_t cols_6[] PROGMEM = {124, 146, 146, 77};
-static const uint8_t cols_7[] PROGMEM = {128, 158, 160, 193};
-static const uint8_t cols_8[] PROGMEM = {108, 146, 146, 109};
-static const uint8_t cols_9[] PROGMEM = {100, 146, 146, 125};
-
-/* The following two arrays point to the font data above. 
- * We store pointers to the beginning of the column data
- * for each letter 
-*/
-static const uint8_t* const letters[26] PROGMEM = {
-		cols_A, cols_B, cols_C, cols_D, cols_E, cols_F,
-		cols_G, cols_H, cols_I, cols_J, cols_K, cols_L,
-		cols_M, cols_N, cols_O, cols_P, cols_Q, cols_R, 
-		cols_S, cols_T, cols_U, cols_V, cols_W, cols_X,
-		cols_Y, cols_Z };
-		
-static const uint8_t* const numbers[10] PROGMEM = {
-		cols_0, cols_1, cols_2, cols_3, cols_4, 
-		cols_5, cols_6, cols_7, cols_8, cols_9 };
+#include "font.h"
 
 /* Keep track of the pixel colour to be used */
 static PixelColour colour = COLOUR_RED;
 
-/* Keep track of which column of data is next to be displayed. 
- * next_col_ptr points to that column, or is 0 if there is
- * no next column.
+/* Messages waiting to be displayed (after the current one). The 
+ * first waiting message is queue[queue_head] and there are queue_count
+ * of them. A message is either a string (flags has SCROLL_STRIP clear)
+ * or a pre-rendered column strip of the given length.
+ */
+#define SCROLL_STRIP 0x80
+
+typedef struct {
+	const void* message;
+	uint16_t length;
+	uint8_t flags;
+	PixelColour colour;
+} ScrollMessage;
+
+static ScrollMessage queue[SCROLL_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+
+/* The message currently being displayed (0 if none), its flags and the 
+ * function to call when it has finished.
+ */
+static const void* current_message = 0;
+static uint8_t current_flags;
+static void (*finished_callback)(const void* message) = 0;
+
+/* Scroll timing for scroll_display_service(), and whether anything
+ * was still scrolling at the last step
  */
-static volatile const uint8_t* next_col_ptr = 0;
+static uint16_t scroll_period = SCROLL_DEFAULT_PERIOD;
+static uint32_t last_scroll_time;
+static uint8_t scrolling = 0;
 
-/* String to be displayed. 
- * next_char_to_display will be used to point to the next
- * character from this string to be displayed.
+/* Countdown of the number of columns to shift until the last message
+ * has disappeared from the display
  */
-static char* display_string;
+static uint8_t shift_countdown = 0;
 
+/* Keep track of which column of data is next to be displayed. 
+ * next_col_ptr points to that column and char_cols_remaining is 
+ * the number of columns of the current character still to be 
+ * displayed (0 if there is no next column).
+ */
+static const uint8_t* next_col_ptr = 0;
+static uint8_t char_cols_remaining = 0;
+
+/* next_char_to_display points to the next character from the
+ * message being displayed (if it's a string) to be displayed.
+ */
 static volatile char* next_char_to_display = 0;
 
+/* If a strip is being displayed, next_strip_col points to the next
+ * column of it to be displayed and strip_cols_remaining is the number
+ * of columns still to be displayed.
+ */
+static const uint8_t* next_strip_col;
+static uint16_t strip_cols_remaining = 0;
+
+/*
+ * Set *columns to point to the font data (in program memory) for the 
+ * given character and return the number of columns (0 if we don't have
+ * data for it).
+ */
+static uint8_t font_columns(char c, const uint8_t** columns) {
+	uint8_t offset;
+	
+	if (c >= 'a' && c <= 'z') {
+		/* Character is a lower case letter - displayed as upper case */
+		c = c - 'a' + 'A';
+	}
+	if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) {
+		return 0;
+	}
+	offset = pgm_read_byte(&font_offsets[c - FONT_FIRST_CHAR]);
+	*columns = &font_atlas[offset];
+	return pgm_read_byte(&font_offsets[c - FONT_FIRST_CHAR + 1]) - offset;
+}
+
+static uint8_t add_to_queue(const void* message, uint16_t length, 
+		uint8_t flags, PixelColour c) {
+	ScrollMessage* entry;
+	
+	if(queue_count == SCROLL_QUEUE_SIZE) {
+		return 0;
+	}
+	entry = &queue[(queue_head + queue_count) % SCROLL_QUEUE_SIZE];
+	entry->message = message;
+	entry->length = length;
+	entry->flags = flags;
+	entry->colour = c;
+	queue_count++;
+	scrolling = 1;
+	return 1;
+}
+
 /*
  * Set the message to be displayed - we just copy the 
  * pointer not the string it points to, so it is important
  * that the original string not change after this function
  * is called while the string is still being displayed.
- * We reset the pointers to ensure the next column to be displayed
+ * We discard anything else that is displayed or queued and reset
+ * the pointers to ensure the next column to be displayed
  * comes from the first character of this string.
  */
 void set_scrolling_display_text(char* string_to_display, PixelColour c) {
-	colour = c;
-	display_string = string_to_display;
-	next_col_ptr = 0;
+	scroll_display_stop();
+	scroll_display_queue_text(string_to_display, c);
+}
+
+uint8_t scroll_display_queue_text(char* string_to_display, PixelColour c) {
+	return add_to_queue(string_to_display, 0, SCROLL_LEFT, c);
+}
+
+uint16_t scroll_render_strip(char* string, uint8_t* strip, uint16_t max_columns) {
+	uint16_t length = 0;
+	uint8_t width;
+	const uint8_t* font_ptr;
+	
+	while(*string) {
+		/* Each character needs a blank column followed by the font
+		 * data (if any)
+		 */
+		width = font_columns(*string, &font_ptr);
+		if(length + 1 + width > max_columns) {
+			break;
+		}
+		strip[length++] = 0;
+		while(width--) {
+			strip[length++] = pgm_read_byte(font_ptr++);
+		}
+		string++;
+	}
+	return length;
+}
+
+uint8_t scroll_display_queue_strip(const uint8_t* strip, uint16_t length,
+		PixelColour c, uint8_t flags) {
+	return add_to_queue(strip, length, flags | SCROLL_STRIP, c);
+}
+
+void scroll_display_stop(void) {
+	queue_count = 0;
+	current_message = 0;
+	char_cols_remaining = 0;
 	next_char_to_display = 0;
+	strip_cols_remaining = 0;
+	shift_countdown = 0;
+	scrolling = 0;
+}
+
+void scroll_display_set_callback(void (*finished)(const void* message)) {
+	finished_callback = finished;
+}
+
+void scroll_display_set_period(uint16_t period) {
+	scroll_period = period;
+}
+
+uint8_t scroll_display_service(uint32_t now) {
+	if(scrolling && now - last_scroll_time >= scroll_period) {
+		last_scroll_time = now;
+		scrolling = scroll_display();
+	}
+	return scrolling;
 }
 
 /*
@@ -142,11 +223,12 @@ void set_scrolling_display_text(char* string_to_display, PixelColour c) {
  * Returns 1 if still scrolling display.
  */
 uint8_t scroll_display(void) {
-	static uint8_t shift_countdown = 0;
 	uint8_t i;
 	uint8_t col_data;
 	char next_char;
 	uint8_t finished = 0;
+	const void* finished_message = 0;
+	ScrollMessage* entry;
 
 	/* Data to be displayed in the next column - by 
 	 * default we show a blank column. Bit 7 of this
@@ -155,31 +237,42 @@ uint8_t scroll_display(void) {
 	 */
 	col_data = 0;
 
-	if(next_col_ptr) {
-		/* We're currently outputting a character and next_col_ptr
-		 * points to the display data for the next column. We
-		 * extract that data from program memory.
+	if(strip_cols_remaining) {
+		/* We're outputting a pre-rendered strip - the column data is
+		 * ready to go, we just move on to the next column.
 		 */
-		col_data = pgm_read_byte(next_col_ptr);
-
-		if(col_data & 1) {
-			/* Least significant bit is set - this is the last
-			 * column of this character
-			 */
-			next_col_ptr = 0;
+		if(current_flags & SCROLL_PROGMEM) {
+			col_data = pgm_read_byte(next_strip_col);
+		} else {
+			col_data = *next_strip_col;
+		}
+		if(current_flags & SCROLL_RIGHT) {
+			next_strip_col--;
 		} else {
-			/* This is not the last column of this character - make
-			 * the pointer point to the data for the next column.
+			next_strip_col++;
+		}
+		if(--strip_cols_remaining == 0) {
+			/* That was the last column - set our countdown until
+			 * the message disappears from the display
 			 */
-			next_col_ptr++;
+			shift_countdown = 16;
 		}
+	} else if(char_cols_remaining) {
+		/* We're currently outputting a character and next_col_ptr
+		 * points to the display data for the next column. We
+		 * extract that data from program memory and make the 
+		 * pointer point to the data for the column after.
+		 */
+		col_data = pgm_read_byte(next_col_ptr++);
+		char_cols_remaining--;
 	} else if(next_char_to_display) {
 		/* We're not currently outputting a character, but we
 		 * do have more characters to display. We will output
 		 * a blank column this time (col_data value remains 0)
 		 * but we will set up our pointer (next_col_ptr) so that
 		 * it points to the data for the first column of dots for
-		 * the next character. We first get the next character to be 
+		 * the next character (and char_cols_remaining to the
+		 * number of columns). We first get the next character to be 
 		 * displayed and advance our next character pointer 
 		 * (next_char_to_display) so that it points to the character 
 		 * after.
@@ -193,40 +286,48 @@ uint8_t scroll_display(void) {
 			 */
 			next_char_to_display = 0;
 			shift_countdown = 16;
-		} else if (next_char >= 'a' && next_char <= 'z') {
-			/* Character is a lower case letter - the next column to 
-			 * be displayed will be the first column of the letter
-			 * data for that letter
+		} else {
+			/* The next column to be displayed will be the first 
+			 * column of the font data for that character (or a 
+			 * blank column if we don't have any)
 			 */
-			next_col_ptr = (const uint8_t*)pgm_read_word(&letters[next_char - 'a']);
-		} else if (next_char >= 'A' && next_char <= 'Z') {
-			/* Upper case character */
-			next_col_ptr = (const uint8_t*)pgm_read_word(&letters[next_char - 'A']);
-		} else if (next_char >= '0' && next_char <= '9') {
-			/* Digit */
-			next_col_ptr = (const uint8_t*)pgm_read_word(&numbers[next_char - '0']);
+			char_cols_remaining = font_columns(next_char, &next_col_ptr);
 		}
-	} else {
-		/* We're not outputting a column of dots and there is 
-		 * no next character. Move on to the string that we
-		 * have stored (if any).
+	} else if(shift_countdown == 0) {
+		/* We're not outputting a column of dots, there is 
+		 * no next character and the last message has scrolled 
+		 * off the display. That message (if any) is finished - 
+		 * move on to the next queued message (if any).
 		 */
-		if(!display_string) {
-			/* May be finished - flag this and adjust below if we're still
-			 * showing pixels
-			 */
+		finished_message = current_message;
+		if(queue_count) {
+			entry = &queue[queue_head];
+			current_message = entry->message;
+			current_flags = entry->flags;
+			colour = entry->colour;
+			queue_head = (queue_head + 1) % SCROLL_QUEUE_SIZE;
+			queue_count--;
+			if(current_flags & SCROLL_STRIP) {
+				/* Scrolling right starts from the end of the strip */
+				next_strip_col = (const uint8_t*)current_message;
+				if(current_flags & SCROLL_RIGHT) {
+					next_strip_col += entry->length - 1;
+				}
+				strip_cols_remaining = entry->length;
+			} else {
+				next_char_to_display = (char*)current_message;
+			}
+		} else {
+			current_message = 0;
 			finished = 1;
 		}
-		next_char_to_display = display_string;
-		display_string = 0;
 	}
 	
-	/* Shift the current display one pixel to the left and insert the 
-	 * new column data at column 15.
+	/* Shift the current display one pixel (normally to the left) and 
+	 * insert the new column data at the edge we've shifted away from.
 	 * Adjust our "finished" variable if we've finished scrolling the
 	 * message off the display
 	 */
-	ledmatrix_shift_display_left();
 	MatrixColumn column_colour_data;
 	for(i=7; i>=1; i--) {
 		// If the relevant font bit is set, we make this a red pixel, otherwise blank
@@ -238,10 +339,20 @@ uint8_t scroll_display(void) {
 		col_data <<= 1;
 	}
 	column_colour_data[0] = 0;
-	ledmatrix_update_column(15, column_colour_data);
+	if(current_flags & SCROLL_RIGHT) {
+		ledmatrix_shift_display_right();
+		ledmatrix_update_column(0, column_colour_data);
+	} else {
+		ledmatrix_shift_display_left();
+		ledmatrix_update_column(15, column_colour_data);
+	}
 	if(shift_countdown > 0) {
 		shift_countdown--;
 	}
-	finished = finished && (shift_countdown == 0);
+	if(finished_message && finished_callback) {
+		finished_callback(finished_message);
+		/* The callback may have queued another message */
+		finished = finished && !queue_count;
+	}
 	return !finished;
 }
@@ -13,15 +13,74 @@
 /* Sets the text to be displayed and the colour it will be
  * scrolled with. The message will start displaying immediately
  * so will overwrite/interfere with any currently scrolling
- * message. To avoid this, wait until the scroll_display()
- * function below has returned 0 to indicate the message scrolling
- * is complete. Note that this string is not 
+ * message. (Any queued messages are also discarded.) To avoid 
+ * this, wait until the scroll_display() function below has 
+ * returned 0 to indicate the message scrolling is complete, or
+ * use scroll_display_queue_text(). Note that this string is not 
  * copied, so it is important that this string not change
  * after this function is called while the string is still
  * being displayed.
  */
 void set_scrolling_display_text(char* string, PixelColour colour);
 
+/* Add a message to the queue of messages to be displayed. Each
+ * message is scrolled completely off the display before the next
+ * one starts. As for set_scrolling_display_text(), the string is
+ * not copied. Returns 1 if the message was queued, 0 if the queue
+ * is full (SCROLL_QUEUE_SIZE messages waiting, not counting the one
+ * being displayed).
+ */
+#define SCROLL_QUEUE_SIZE 4
+uint8_t scroll_display_queue_text(char* string, PixelColour colour);
+
+/* Pre-rendered column strips. Rather than looking up the font for
+ * each column as it's displayed, a message can be rendered once into 
+ * a strip of columns - one byte per column, bit 7 to bit 1 being rows
+ * 7 to 1 as for the font below (bit 0, row 0, is not displayed). Each
+ * step of the scroll is then just a read of the next byte. This suits
+ * messages that are shown over and over. A strip can be in RAM (e.g. 
+ * rendered by scroll_render_strip()) or in program memory.
+ */
+
+/* Render the given string into a strip of at most max_columns columns.
+ * Each character takes a blank column followed by the font columns for 
+ * that character - at most SCROLL_COLUMNS_PER_CHAR columns in all. If
+ * the strip isn't big enough then only the characters that fit are 
+ * rendered. Returns the number of columns in the strip.
+ */
+#define SCROLL_COLUMNS_PER_CHAR 6
+uint16_t scroll_render_strip(char* string, uint8_t* strip, uint16_t max_columns);
+
+/* Flags for scroll_display_queue_strip(). By default (SCROLL_LEFT) the 
+ * message moves from right to left, first column first. With 
+ * SCROLL_RIGHT it moves from left to right, last column first (so the
+ * message still reads the right way round). SCROLL_PROGMEM indicates 
+ * that the strip is in program memory rather than RAM.
+ */
+#define SCROLL_LEFT		0
+#define SCROLL_RIGHT	1
+#define SCROLL_PROGMEM	2
+
+/* Add a strip of the given length (columns) to the queue of messages to
+ * be displayed. The strip is not copied. Returns 1 if the strip was 
+ * queued, 0 if the queue is full.
+ */
+uint8_t scroll_display_queue_strip(const uint8_t* strip, uint16_t length,
+		PixelColour colour, uint8_t flags);
+
+/* Stop scrolling - discard the current message and any queued 
+ * messages. The display is left as it is.
+ */
+void scroll_display_stop(void);
+
+/* Set a function to be called each time a message has finished
+ * (i.e. has scrolled completely off the display). It is passed the
+ * string or strip that was displayed. Pass 0 for no function. The 
+ * function is called from scroll_display() so may queue another 
+ * message.
+ */
+void scroll_display_set_callback(void (*finished)(const void* message));
+
 /* Scroll the display. Should be called whenever the display
  * is to be scrolled one pixel to the left. It is recommended that
  * this function NOT be called from an interrupt service routine as
@@ -30,5 +89,22 @@ void set_scrolling_display_text(char* string, PixelColour colour);
  * Returns 1 while a message is still scrolling, 0 when done.
  */
 uint8_t scroll_display(void);
+
+/* Set the time between scroll steps (milliseconds) used by
+ * scroll_display_service() below. The default is 
+ * SCROLL_DEFAULT_PERIOD.
+ */
+#define SCROLL_DEFAULT_PERIOD 150
+void scroll_display_set_period(uint16_t period);
+
+/* Scroll the display if it's time to. This is intended to be called
+ * from a main loop as often as possible with the current time in
+ * milliseconds (e.g. from get_current_time()) - it calls 
+ * scroll_display() once every scroll period and otherwise returns 
+ * straight away, so the loop can deal with other things (such as 
+ * button presses) in between steps.
+ * Returns 1 while a message is still scrolling, 0 when done.
+ */
+uint8_t scroll_display_service(uint32_t now);
 	
 #endif /* SCROLLING_CHAR_DISPLAY_H_ */
\ No newline at end of file
@@ -26,6 +26,9 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 
+#include "serialio.h"
+#include "isrstats.h"
+
 /* System clock rate in Hz. (L at the end indicates this is a long constant) */
 #define SYSCLK 8000000L
 
@@ -53,7 +56,11 @@ volatile uint8_t bytes_in_out_buffer;
 volatile char input_buffer[INPUT_BUFFER_SIZE];
 volatile uint8_t input_insert_pos;
 volatile uint8_t bytes_in_input_buffer;
-volatile uint8_t input_overrun;
+
+/* Number of incoming characters thrown away because the input buffer
+ * was full (see serial_input_overruns())
+ */
+volatile uint16_t input_overruns;
 
 /* Variable to keep track of whether incoming characters are to be echoed
  * back or not.
@@ -62,9 +69,10 @@ static int8_t do_echo;
 
 /* Function prototypes 
  */
-void init_serial_stdio(long baudrate, int8_t echo);
+int8_t init_serial_stdio(long baudrate, int8_t echo);
 static int uart_put_char(char, FILE*);
 static int uart_get_char(FILE*);
+static int buffer_output_byte(uint8_t);
 
 /* Setup a stream that uses the uart get and put functions. We will
  * make standard input and output use this stream below.
@@ -72,8 +80,69 @@ static int uart_get_char(FILE*);
 static FILE myStream = FDEV_SETUP_STREAM(uart_put_char, uart_get_char,
 		_FDEV_SETUP_RW);
 
-void init_serial_stdio(long baudrate, int8_t echo) {
+/* Work out the UBRR0 value and speed mode (U2X0 set or not) which give 
+ * the baud rate closest to the one asked for. Both the normal (16 clocks
+ * per bit) and double speed (8 clocks per bit) modes are tried. Returns
+ * the error in the actual baud rate in tenths of a percent, or -1 if the
+ * rate can't be generated at all. If the two modes are equally close,
+ * normal mode is used as the receiver takes more samples per bit.
+ */
+static int16_t choose_baud_setting(long baudrate, uint16_t* ubrr, 
+		uint8_t* double_speed) {
+	int16_t best_error = -1;
+	uint8_t clocks_per_bit;
+	long divisor;
+	long actual;
+	long error;
+	
+	if(baudrate <= 0) {
+		return -1;
+	}
+	for(clocks_per_bit = 16; clocks_per_bit >= 8; clocks_per_bit -= 8) {
+		/* (This differs from the datasheet formula so that we get 
+		 * rounding to the nearest integer while using integer division
+		 * (which truncates)).
+		 */
+		divisor = ((SYSCLK / ((clocks_per_bit / 2) * baudrate)) + 1)/2;
+		if(divisor < 1 || divisor > 4096) {
+			/* UBRR0 is 12 bits */
+			continue;
+		}
+		actual = SYSCLK / (clocks_per_bit * divisor);
+		error = actual - baudrate;
+		if(error < 0) {
+			error = -error;
+		}
+		error = (error * 1000) / baudrate;
+		if(best_error < 0 || error < best_error) {
+			best_error = error;
+			*ubrr = divisor - 1;
+			*double_speed = (clocks_per_bit == 8);
+		}
+	}
+	return best_error;
+}
+
+int16_t serial_baud_error(long baudrate) {
 	uint16_t ubrr;
+	uint8_t double_speed;
+	return choose_baud_setting(baudrate, &ubrr, &double_speed);
+}
+
+int8_t init_serial_stdio(long baudrate, int8_t echo) {
+	uint16_t ubrr;
+	uint8_t double_speed;
+	int16_t error;
+	
+	/*
+	 * Check that we can generate the baud rate closely enough before
+	 * changing anything
+	*/
+	error = choose_baud_setting(baudrate, &ubrr, &double_speed);
+	if(error < 0 || error > SERIAL_MAX_BAUD_ERROR) {
+		return 0;
+	}
+	
 	/*
 	 * Initialise our buffers
 	*/
@@ -81,7 +150,7 @@ void init_serial_stdio(long baudrate, int8_t echo) {
 	bytes_in_out_buffer = 0;
 	input_insert_pos = 0;
 	bytes_in_input_buffer = 0;
-	input_overrun = 0;
+	input_overruns = 0;
 	
 	/*
 	 * Record whether we're going to echo characters or not
@@ -89,12 +158,12 @@ void init_serial_stdio(long baudrate, int8_t echo) {
 	do_echo = echo;
 	
 	/* Configure the serial port baud rate */
-	/* (This differs from the datasheet formula so that we get 
-	 * rounding to the nearest integer while using integer division
-	 * (which truncates)).
-	*/
-	ubrr = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
 	UBRR0 = ubrr;
+	if(double_speed) {
+		UCSR0A |= (1<<U2X0);
+	} else {
+		UCSR0A &= ~(1<<U2X0);
+	}
 	
 	/*
 	 * Enable transmission and receiving via UART. We don't enable
@@ -116,6 +185,7 @@ void init_serial_stdio(long baudrate, int8_t echo) {
 	*/
 	stdout = &myStream;
 	stdin = &myStream;
+	return 1;
 }
 
 int8_t serial_input_available(void) {
@@ -123,24 +193,70 @@ int8_t serial_input_available(void) {
 }
 
 void clear_serial_input_buffer(void) {
-	/* Just adjust our buffer data so it looks empty */
+	/* Just adjust our buffer data so it looks empty. Interrupts are
+	 * turned off so that a character can't arrive in between.
+	 */
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
 	input_insert_pos = 0;
 	bytes_in_input_buffer = 0;
+	if(interrupts_enabled) {
+		sei();
+	}
 }
 
-static int uart_put_char(char c, FILE* stream) {
-	uint8_t interrupts_enabled;
+uint16_t serial_input_overruns(void) {
+	uint16_t overruns;
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
 	
-	/* Add the character to the buffer for transmission (if there 
-	 * is space to do so). If not we wait until the buffer has space.
-	 * If the character is \n, we output \r (carriage return)
+	/* 16 bit value - interrupts must be off while it's read */
+	cli();
+	overruns = input_overruns;
+	if(interrupts_enabled) {
+		sei();
+	}
+	return overruns;
+}
+
+void serial_write_frame(uint8_t type, const uint8_t* data, uint16_t length) {
+	uint8_t checksum;
+	
+	/* Frame layout is
+	 *     SERIAL_FRAME_START, type, length (low byte), length (high byte),
+	 *     data bytes ..., checksum
+	 * where the checksum is chosen so that all the bytes after the start
+	 * byte add up to zero (modulo 256). Bytes are output exactly as given
+	 * (no \n to \r\n translation).
+	 */
+	(void)buffer_output_byte(SERIAL_FRAME_START);
+	(void)buffer_output_byte(type);
+	(void)buffer_output_byte(length & 0xFF);
+	(void)buffer_output_byte(length >> 8);
+	checksum = type + (length & 0xFF) + (length >> 8);
+	for(uint16_t i = 0; i < length; i++) {
+		(void)buffer_output_byte(data[i]);
+		checksum += data[i];
+	}
+	(void)buffer_output_byte(-checksum);
+}
+
+static int uart_put_char(char c, FILE* stream) {
+	/* If the character is \n, we output \r (carriage return)
 	 * also.
 	*/
 	if(c == '\n') {
 		uart_put_char('\r', stream);
 	}
+	return buffer_output_byte(c);
+}
+
+static int buffer_output_byte(uint8_t c) {
+	uint8_t interrupts_enabled;
 	
-	/* If the buffer is full and interrupts are disabled then we
+	/* Add the character to the buffer for transmission (if there 
+	 * is space to do so). If not we wait until the buffer has space.
+	 *
+	 * If the buffer is full and interrupts are disabled then we
 	 * abort - we don't output the character since the buffer will
 	 * never be emptied if interrupts are disabled. If the buffer is full
 	 * and interrupts are enabled then we loop until the buffer has 
@@ -165,6 +281,7 @@ static int uart_put_char(char c, FILE* stream) {
 	 * function.
 	*/	
 	cli();
+	ISR_STATS_BEGIN();
 	out_buffer[out_insert_pos++] = c;
 	bytes_in_out_buffer++;
 	if(out_insert_pos == OUTPUT_BUFFER_SIZE) {
@@ -175,6 +292,7 @@ static int uart_put_char(char c, FILE* stream) {
 	 * disabled) - we ensure it is now enabled so that it will
 	 * fire and deal with the next character in the buffer. */
 	UCSR0B |= (1 << UDRIE0);
+	ISR_STATS_END(CS_UART_PUT_CHAR);
 	if(interrupts_enabled) {
 		sei();
 	}
@@ -196,6 +314,7 @@ int uart_get_char(FILE* stream) {
 	 */
 	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
 	cli();
+	ISR_STATS_BEGIN();
 	char c;
 	if(input_insert_pos - bytes_in_input_buffer < 0) {
 		/* Need to wrap around */
@@ -207,6 +326,7 @@ int uart_get_char(FILE* stream) {
 	
 	/* Decrement our count of bytes in the input buffer */
 	bytes_in_input_buffer--;
+	ISR_STATS_END(CS_UART_GET_CHAR);
 	if(interrupts_enabled) {
 		sei();
 	}	
@@ -219,6 +339,7 @@ int uart_get_char(FILE* stream) {
  */
 ISR(USART0_UDRE_vect) 
 {
+	ISR_STATS_BEGIN();
 	/* Check if we have data in our buffer */
 	if(bytes_in_out_buffer > 0) {
 		/* Yes we do - remove the pending byte and output it
@@ -251,6 +372,7 @@ ISR(USART0_UDRE_vect)
 		 */
 		UCSR0B &= ~(1<<UDRIE0);
 	}
+	ISR_STATS_END(CS_ISR_USART_UDRE);
 }
 
 /*
@@ -261,6 +383,7 @@ ISR(USART0_UDRE_vect)
 
 ISR(USART0_RX_vect) 
 {
+	ISR_STATS_BEGIN();
 	/* Read the character - we ignore the possibility of overrun. */
 	char c;
 	c = UDR0;
@@ -275,13 +398,14 @@ ISR(USART0_RX_vect)
 	}
 	
 	/* 
-	 * Check if we have space in our buffer. If not, set the overrun
-	 * flag and throw away the character. (We never clear the 
-	 * overrun flag - it's up to the programmer to check/clear
-	 * this flag if desired.)
+	 * Check if we have space in our buffer. If not, count the overrun
+	 * and throw away the character. (The count is never reset - it
+	 * stops at its maximum value.)
 	 */
 	if(bytes_in_input_buffer >= INPUT_BUFFER_SIZE) {
-		input_overrun = 1;
+		if(input_overruns != 0xFFFF) {
+			input_overruns++;
+		}
 	} else {
 		/* If the character is a carriage return, turn it into a
 		 * linefeed 
@@ -300,4 +424,5 @@ ISR(USART0_RX_vect)
 			input_insert_pos = 0;
 		}
 	}
+	ISR_STATS_END(CS_ISR_USART_RX);
 }
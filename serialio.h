@@ -21,9 +21,24 @@
 /* Initialise serial IO using the UART. baudrate specifies the desired
  * baud rate (e.g. 19200) and echo determines whether incoming characters
  * are echoed back to the UART output as they are received (zero means no
- * echo, non-zero means echo)
+ * echo, non-zero means echo).
+ * The UART's normal or double speed (U2X0) mode is used, whichever gets
+ * closer to the baud rate. Returns 1 if successful, or 0 (and nothing is
+ * changed) if the baud rate can't be generated to within 
+ * SERIAL_MAX_BAUD_ERROR. With the 8MHz clock:
+ *     9600, 19200, 38400   normal mode, 0.2% error
+ *     76800                double speed, 0.2% error
+ *     57600                rejected - 2.1% error (double speed)
+ *     115200               rejected - 3.5% error (double speed)
  */
-void init_serial_stdio(long baudrate, int8_t echo);
+#define SERIAL_MAX_BAUD_ERROR	20	/* tenths of a percent */
+int8_t init_serial_stdio(long baudrate, int8_t echo);
+
+/* Return the error (in tenths of a percent) in the closest baud rate 
+ * to the given one that the UART can generate, or -1 if it can't get
+ * anywhere near it.
+ */
+int16_t serial_baud_error(long baudrate);
 
 /* Test if input is available from the serial port. Return 0 if not,
  * non-zero otherwise. If there is input available then it can be read
@@ -36,4 +51,22 @@ int8_t serial_input_available(void);
  */
 void clear_serial_input_buffer(void);
 
+/* Return the number of characters received that were thrown away 
+ * because the input buffer was full, since init_serial_stdio(). (The
+ * count stops at 65535.)
+ */
+uint16_t serial_input_overruns(void);
+
+/* Output a block of binary data as a frame (see serialio.c for the
+ * layout). The frame is mixed in with any other terminal output, so
+ * a host tool reading a log of the serial port output finds frames by 
+ * looking for SERIAL_FRAME_START and checking the checksum. type
+ * identifies what the data is (see SERIAL_FRAME_... below).
+ * Blocks until all of the data is in the output buffer.
+ */
+#define SERIAL_FRAME_START	0xA5
+#define SERIAL_FRAME_REPLAY	'R'
+#define SERIAL_FRAME_SPI_CAPTURE	'S'
+void serial_write_frame(uint8_t type, const uint8_t* data, uint16_t length);
+
 #endif /* SERIALIO_H_ */
\ No newline at end of file
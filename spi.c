@@ -7,6 +7,77 @@
 #include <avr/io.h>
 #include "spi.h"
 
+#ifdef SPI_CAPTURE
+#include "serialio.h"
+#include "timer0.h"
+
+// Capture buffer - the header (filled in when it's dumped) followed by a
+// ring of 3 byte entries. next_entry is where the next byte goes and
+// total counts all of the bytes sent (so the buffer is full once it 
+// reaches SPI_CAPTURE_SIZE).
+#define CAPTURE_HEADER_SIZE	5
+#define CAPTURE_ENTRY_SIZE	3
+static uint8_t capture[CAPTURE_HEADER_SIZE + 
+		SPI_CAPTURE_SIZE * CAPTURE_ENTRY_SIZE];
+static uint8_t next_entry;
+static uint32_t total;
+
+static void capture_byte(uint8_t byte) {
+	uint8_t* entry = &capture[CAPTURE_HEADER_SIZE + 
+			next_entry * CAPTURE_ENTRY_SIZE];
+	uint16_t now = get_current_time16();
+	
+	entry[0] = byte;
+	entry[1] = now & 0xFF;
+	entry[2] = now >> 8;
+	if(++next_entry == SPI_CAPTURE_SIZE) {
+		next_entry = 0;
+	}
+	total++;
+}
+
+// Reverse the order of the entries from first to last - 1
+static void reverse_entries(uint8_t first, uint8_t last) {
+	uint8_t* a;
+	uint8_t* b;
+	uint8_t temp;
+	
+	while(first + 1 < last) {
+		last--;
+		a = &capture[CAPTURE_HEADER_SIZE + first * CAPTURE_ENTRY_SIZE];
+		b = &capture[CAPTURE_HEADER_SIZE + last * CAPTURE_ENTRY_SIZE];
+		for(uint8_t i = 0; i < CAPTURE_ENTRY_SIZE; i++) {
+			temp = a[i];
+			a[i] = b[i];
+			b[i] = temp;
+		}
+		first++;
+	}
+}
+
+void spi_capture_dump(void) {
+	uint8_t entries = SPI_CAPTURE_SIZE;
+	
+	if(total < SPI_CAPTURE_SIZE) {
+		entries = total;
+	} else if(next_entry != 0) {
+		// Rotate the ring so that the oldest entry is first (by 
+		// reversing each part and then the whole lot)
+		reverse_entries(0, next_entry);
+		reverse_entries(next_entry, SPI_CAPTURE_SIZE);
+		reverse_entries(0, SPI_CAPTURE_SIZE);
+		next_entry = 0;
+	}
+	
+	capture[0] = SPI_CAPTURE_VERSION;
+	for(uint8_t i = 0; i < 4; i++) {
+		capture[1 + i] = (total >> (8 * i)) & 0xFF;
+	}
+	serial_write_frame(SERIAL_FRAME_SPI_CAPTURE, capture, 
+			CAPTURE_HEADER_SIZE + entries * CAPTURE_ENTRY_SIZE);
+}
+#endif /* SPI_CAPTURE */
+
 void spi_setup_master(uint8_t clockdivider) {
 	// Set up SPI communication as a master
 	// Make the SS, MOSI and SCK pins outputs. These are pins
@@ -61,6 +132,9 @@ uint8_t spi_send_byte(uint8_t byte) {
 	// complete. (The final read of SPSR0 followed by a read of SPDR0
 	// will cause the SPIF bit to be reset to 0. See page 173 of the 
 	// ATmega324A datasheet.)
+#ifdef SPI_CAPTURE
+	capture_byte(byte);
+#endif
 	SPDR0 = byte;
 	while((SPSR0 & (1<<SPIF0)) == 0) {
 		; // wait
@@ -7,6 +7,8 @@
 #ifndef SPI_H_
 #define SPI_H_
 
+#include <stdint.h>
+
 // Set up SPI communication as a master.
 // clockdivider should be one of 2,4,8,16,32,64,128
 void spi_setup_master(uint8_t clockdivider);
@@ -15,4 +17,23 @@ void spi_setup_master(uint8_t clockdivider);
 // cyles of the divided clock (i.e. will busy wait).
 uint8_t spi_send_byte(uint8_t byte);
 
+// SPI capture. Uncomment (or define SPI_CAPTURE in the project symbols)
+// to keep a copy of the last SPI_CAPTURE_SIZE bytes sent, each with the
+// low 16 bits of the time (milliseconds - see timer0.h) it was sent at.
+// spi_capture_dump() sends them over the serial port as a 
+// SERIAL_FRAME_SPI_CAPTURE frame (see serialio.h) laid out as
+//     SPI_CAPTURE_VERSION, total bytes sent since reset (4 bytes), 
+//     then for each byte captured (oldest first): byte, time (2 bytes)
+// with multi-byte values little endian. Without SPI_CAPTURE, 
+// spi_capture_dump() does nothing.
+//#define SPI_CAPTURE
+#define SPI_CAPTURE_VERSION 1
+#define SPI_CAPTURE_SIZE 128	// at most 255
+
+#ifdef SPI_CAPTURE
+void spi_capture_dump(void);
+#else
+#define spi_capture_dump()
+#endif
+
 #endif /* SPI_H_ */
\ No newline at end of file
@@ -84,3 +84,23 @@ void draw_vertical_line(int8_t x, int8_t start_y, int8_t end_y) {
 	printf(" ");
 	normal_display_mode();
 }
+
+int16_t decode_terminal_input(uint8_t* state, char c) {
+	// state is the number of characters of an escape sequence we've had
+	if(c == ESCAPE_CHAR) {
+		*state = 1;
+		return TERMINAL_INPUT_NONE;
+	}
+	if(*state == 1 && c == '[') {
+		*state = 2;
+		return TERMINAL_INPUT_NONE;
+	}
+	if(*state == 2) {
+		*state = 0;
+		return TERMINAL_KEY(c);
+	}
+	// Not part of an escape sequence (or the character after ESC wasn't
+	// [) - it's ordinary input
+	*state = 0;
+	return (uint8_t)c;
+}
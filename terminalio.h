@@ -86,4 +86,21 @@ void scroll_up(void);
 void draw_horizontal_line(int8_t y, int8_t startx, int8_t endx);
 void draw_vertical_line(int8_t x, int8_t starty, int8_t endy);
 
+// Decoding of input from the terminal. Cursor keys are sent as escape
+// sequences: ESC [ A (up), ESC [ B (down), ESC [ C (right) and ESC [ D 
+// (left). Each character read from the terminal is passed to 
+// decode_terminal_input() with a state variable (which must start at 0,
+// and be set back to 0 to forget a partly received sequence). It returns
+//     - the character (0 to 255) if it's ordinary input,
+//     - TERMINAL_KEY(c) if it completes the escape sequence ESC [ c, or
+//     - TERMINAL_INPUT_NONE if it's the start of an escape sequence.
+// An ESC always starts a new escape sequence, dropping any unfinished
+// one. If an ESC is followed by anything other than [ or another ESC, 
+// the ESC is dropped and the character is ordinary input.
+#define ESCAPE_CHAR				27
+#define TERMINAL_INPUT_NONE		(-1)
+#define TERMINAL_KEY(c)			(0x100 | (uint8_t)(c))
+#define IS_TERMINAL_KEY(input)	((input) >= 0x100)
+int16_t decode_terminal_input(uint8_t* state, char c);
+
 #endif /* TERMINAL_IO_H */
\ No newline at end of file
@@ -0,0 +1,221 @@
+/*
+ * tickstats.c
+ *
+ * Game tick execution time measurements - see tickstats.h
+ */
+
+#include "tickstats.h"
+
+#ifdef TICK_STATS
+
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+#include "game.h"
+#include "score.h"
+#include "terminalio.h"
+
+// Budget for each phase (the whole tick's is the asteroid period)
+static const uint16_t budgets[TICK_PHASE_TOTAL] PROGMEM = {
+		TICK_BUDGET_INPUT, TICK_BUDGET_PROJECTILES, TICK_BUDGET_ASTEROIDS,
+		TICK_BUDGET_HUD, TICK_BUDGET_LED_FLUSH };
+
+static const char phase_name_0[] PROGMEM = "input";
+static const char phase_name_1[] PROGMEM = "projectiles";
+static const char phase_name_2[] PROGMEM = "asteroids";
+static const char phase_name_3[] PROGMEM = "HUD";
+static const char phase_name_4[] PROGMEM = "LED flush";
+static const char phase_name_5[] PROGMEM = "whole tick";
+
+static const char* const phase_names[TICK_NUM_PHASES] PROGMEM = {
+		phase_name_0, phase_name_1, phase_name_2, phase_name_3,
+		phase_name_4, phase_name_5 };
+
+// The tick under way - when it started and the time spent in each phase
+// so far
+static uint8_t inTick;
+static uint8_t discardTick;
+static uint32_t tickStart;
+static uint32_t phaseTime[TICK_NUM_PHASES];
+
+// Over all ticks - the number of ticks, and the maximum time and number
+// of budget violations for each phase
+static uint32_t ticks;
+static uint32_t phaseMax[TICK_NUM_PHASES];
+static uint16_t phaseOver[TICK_NUM_PHASES];
+
+// Maximum whole tick for each group of asteroid periods, and the 
+// shortest period seen in the group (0 if none). periods[0] is the
+// longest periods.
+typedef struct {
+	uint16_t period;
+	uint32_t worst;
+} PeriodStats;
+
+static PeriodStats periods[TICK_STATS_PERIODS];
+
+// Budget violations, with the state of the game at the end of the tick.
+// violations[logNext] is the oldest once the log is full.
+typedef struct {
+	uint32_t gameTime;
+	uint32_t time;
+	uint16_t score;
+	uint16_t period;
+	uint8_t phase;
+	int8_t base;
+	uint8_t projectiles;
+} TickViolation;
+
+static TickViolation violations[TICK_STATS_LOG_SIZE];
+static uint8_t logNext;
+static uint8_t logCount;
+
+void tickstats_start_tick(void) {
+	if(inTick) {
+		return;
+	}
+	inTick = 1;
+	discardTick = 0;
+	for(uint8_t phase = 0; phase < TICK_NUM_PHASES; phase++) {
+		phaseTime[phase] = 0;
+	}
+	tickStart = tickstats_now();
+}
+
+void tickstats_discard_tick(void) {
+	discardTick = 1;
+}
+
+void tickstats_add(TickPhase phase, uint32_t start) {
+	phaseTime[phase] += tickstats_now() - start;
+}
+
+static void log_violation(uint8_t phase, uint16_t period) {
+	TickViolation* entry = &violations[logNext];
+	uint8_t projectiles = 0;
+
+	if(phaseOver[phase] != 0xFFFF) {
+		phaseOver[phase]++;
+	}
+	entry->gameTime = last_move_time();
+	entry->time = phaseTime[phase];
+	entry->score = get_score();
+	entry->period = period;
+	entry->phase = phase;
+	entry->base = get_base_position();
+	for(uint8_t x = 0; x < FIELD_WIDTH; x++) {
+		projectiles += projectiles_in_column(x);
+	}
+	entry->projectiles = projectiles;
+
+	logNext = (logNext + 1) % TICK_STATS_LOG_SIZE;
+	if(logCount < TICK_STATS_LOG_SIZE) {
+		logCount++;
+	}
+}
+
+// Keep track of the worst whole tick for the given asteroid period
+static void add_to_period(uint16_t period, uint32_t time) {
+	uint8_t i = (ASTEROID_PERIOD - period) / TICK_STATS_PERIOD_STEP;
+
+	if(i >= TICK_STATS_PERIODS) {
+		i = TICK_STATS_PERIODS - 1;
+	}
+	if(periods[i].period == 0 || period < periods[i].period) {
+		periods[i].period = period;
+	}
+	if(time > periods[i].worst) {
+		periods[i].worst = time;
+	}
+}
+
+void tickstats_end_tick(void) {
+	uint16_t period;
+	uint32_t budget;
+
+	if(!inTick) {
+		return;
+	}
+	inTick = 0;
+	if(discardTick) {
+		return;
+	}
+	phaseTime[TICK_PHASE_TOTAL] = tickstats_now() - tickStart;
+	period = asteroid_period();
+	ticks++;
+
+	for(uint8_t phase = 0; phase < TICK_NUM_PHASES; phase++) {
+		if(phaseTime[phase] > phaseMax[phase]) {
+			phaseMax[phase] = phaseTime[phase];
+		}
+		if(phase == TICK_PHASE_TOTAL) {
+			budget = (uint32_t)period * 1000;
+		} else {
+			budget = pgm_read_word(&budgets[phase]);
+		}
+		if(phaseTime[phase] > budget) {
+			log_violation(phase, period);
+		}
+	}
+	add_to_period(period, phaseTime[TICK_PHASE_TOTAL]);
+}
+
+// Start the next line of the statistics
+static void next_line(void) {
+	printf_P(PSTR("\n"));
+	clear_to_end_of_line();
+}
+
+void tickstats_print(void) {
+	const TickViolation* entry;
+	int32_t headroom;
+	uint8_t column;
+
+	tickstats_discard_tick();
+	move_cursor(1, 25);
+	clear_to_end_of_line();
+	printf_P(PSTR("%-12S %10S %10S %6S  (%lu ticks)"), PSTR("tick phase"),
+			PSTR("max us"), PSTR("budget us"), PSTR("over"),
+			(unsigned long)ticks);
+	for(uint8_t phase = 0; phase < TICK_NUM_PHASES; phase++) {
+		next_line();
+		printf_P(PSTR("%-12S %10lu "),
+				(const char*)pgm_read_ptr(&phase_names[phase]),
+				(unsigned long)phaseMax[phase]);
+		if(phase == TICK_PHASE_TOTAL) {
+			printf_P(PSTR("%10S"), PSTR("period"));
+		} else {
+			printf_P(PSTR("%10u"), pgm_read_word(&budgets[phase]));
+		}
+		printf_P(PSTR(" %6u"), phaseOver[phase]);
+	}
+
+	// Worst whole tick for each group of asteroid periods and the 
+	// headroom left (percentage of the period)
+	column = 0;
+	for(uint8_t i = 0; i < TICK_STATS_PERIODS; i++) {
+		if(periods[i].period == 0) {
+			continue;
+		}
+		if(column++ % 3 == 0) {
+			next_line();
+		}
+		headroom = 100 - (int32_t)(periods[i].worst / periods[i].period / 10);
+		printf_P(PSTR("%3ums: %6luus %3ld%%   "), periods[i].period,
+				(unsigned long)periods[i].worst, (long)headroom);
+	}
+
+	// Budget violations, oldest first
+	for(uint8_t i = 0; i < logCount; i++) {
+		entry = &violations[(logNext + TICK_STATS_LOG_SIZE - logCount + i) %
+				TICK_STATS_LOG_SIZE];
+		next_line();
+		printf_P(PSTR("%6lums %-11S %6luus score %u period %ums base %d "
+				"projectiles %u"), (unsigned long)entry->gameTime,
+				(const char*)pgm_read_ptr(&phase_names[entry->phase]),
+				(unsigned long)entry->time, entry->score, entry->period,
+				entry->base, entry->projectiles);
+	}
+}
+
+#endif /* TICK_STATS */
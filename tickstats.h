@@ -0,0 +1,128 @@
+/*
+ * tickstats.h
+ *
+ * Worst case execution time (WCET) of each game tick. A tick is one pass
+ * of play_game()'s loop that ends with the frame being shown - any passes
+ * before it that only moved things (see advance_game() in game.h) are
+ * part of the same tick. The time spent in each phase of a tick is added
+ * up:
+ *   TICK_PHASE_INPUT       - reading the buttons and serial input (or the
+ *                            recording or autopilot) and acting on it
+ *   TICK_PHASE_PROJECTILES - advance_projectiles()
+ *   TICK_PHASE_ASTEROIDS   - advance_falling_astroid()
+ *   TICK_PHASE_HUD         - the terminal display (the copy of the playing
+ *                            field, score, lives and messages - any display
+ *                            backend other than the LED matrix counts here)
+ *   TICK_PHASE_LED_FLUSH   - sending changed cells to the LED matrix
+ * and the whole tick is timed as well (TICK_PHASE_TOTAL - which includes
+ * the rest of the loop, e.g. effects and the compositor). If a phase
+ * passes render commands on to the displays (because the render list
+ * filled up) the display time is counted in that phase as well.
+ *
+ * At the end of each tick every phase is checked against its budget. The
+ * whole tick's budget is the current asteroid period (asteroid_period() in
+ * game.h) - a tick that takes longer than that makes the asteroids late.
+ * A tick that goes over budget is logged along with the state of the game
+ * (the last TICK_STATS_LOG_SIZE are kept). The maximum of each phase is
+ * kept, and the maximum whole tick for each asteroid period - so we can
+ * see how much headroom each speed of the game has. (Periods are grouped
+ * in steps of TICK_STATS_PERIOD_STEP milliseconds - high speed mode has
+ * too many to keep them all - and the headroom is worked out for the 
+ * shortest period seen in each group.) tickstats_print()
+ * shows them on the terminal ('w' during a game or at game over), best
+ * after a soak run with the autopilot (see autopilot.h).
+ *
+ * Times are in microseconds, measured with timer 0 (see
+ * get_current_time_us() in timer0.h) so only to the nearest 8us.
+ */
+
+#ifndef TICKSTATS_H_
+#define TICKSTATS_H_
+
+#include <stdint.h>
+
+#include "game.h"
+#include "timer0.h"
+
+// Uncomment (or define TICK_STATS in the project symbols) to compile in
+// the measurements. Without it all of the macros below expand to nothing.
+//#define TICK_STATS
+
+typedef enum {
+	TICK_PHASE_INPUT,
+	TICK_PHASE_PROJECTILES,
+	TICK_PHASE_ASTEROIDS,
+	TICK_PHASE_HUD,
+	TICK_PHASE_LED_FLUSH,
+	TICK_PHASE_TOTAL,
+	TICK_NUM_PHASES
+} TickPhase;
+
+// Budget for each phase (microseconds). These can be defined in the
+// project symbols to change them. The terminal is the slowest by far -
+// at 19200 baud each character takes about 520us once the serial output
+// buffer is full.
+#ifndef TICK_BUDGET_INPUT
+#define TICK_BUDGET_INPUT		1000
+#endif
+#ifndef TICK_BUDGET_PROJECTILES
+#define TICK_BUDGET_PROJECTILES	1000
+#endif
+#ifndef TICK_BUDGET_ASTEROIDS
+#define TICK_BUDGET_ASTEROIDS	2000
+#endif
+#ifndef TICK_BUDGET_HUD
+#define TICK_BUDGET_HUD			50000
+#endif
+#ifndef TICK_BUDGET_LED_FLUSH
+#define TICK_BUDGET_LED_FLUSH	5000
+#endif
+
+// Number of budget violations kept, and the asteroid periods (speeds)
+// kept track of - grouped in steps of TICK_STATS_PERIOD_STEP up to 
+// ASTEROID_PERIOD
+#define TICK_STATS_LOG_SIZE		4
+#define TICK_STATS_PERIOD_STEP	50
+#define TICK_STATS_PERIODS		(ASTEROID_PERIOD / TICK_STATS_PERIOD_STEP)
+
+#ifdef TICK_STATS
+
+// Called at the top of play_game()'s loop - starts a tick unless one is
+// already under way
+void tickstats_start_tick(void);
+
+// Called once the frame has been shown - ends the tick and checks it
+// against the budgets
+void tickstats_end_tick(void);
+
+// Don't count the tick under way (e.g. because it printed statistics,
+// which takes far longer than any tick should)
+void tickstats_discard_tick(void);
+
+// Add to the time spent in a phase in this tick, from the given
+// tickstats_now() value up to now
+void tickstats_add(TickPhase phase, uint32_t start);
+
+// Print the measurements and log to the serial terminal. The tick under
+// way is discarded.
+void tickstats_print(void);
+
+#define tickstats_now()	get_current_time_us()
+
+// Time a phase. TICK_STATS_BEGIN() declares a variable, so can only be
+// used once in a block.
+#define TICK_STATS_BEGIN()			uint32_t tick_stats_start = tickstats_now()
+#define TICK_STATS_END(phase)		tickstats_add((phase), tick_stats_start)
+
+#else
+
+#define tickstats_start_tick()
+#define tickstats_end_tick()
+#define tickstats_discard_tick()
+#define tickstats_print()
+#define TICK_STATS_BEGIN()
+#define TICK_STATS_END(phase)
+
+#endif /* TICK_STATS */
+
+#endif /* TICKSTATS_H_ */
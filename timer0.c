@@ -15,6 +15,7 @@
 #include "score.h"
 #include "pixel_colour.h"
 #include "game.h"
+#include "isrstats.h"
 
 
 
@@ -79,23 +80,58 @@ void init_timer0(void) {
 uint32_t get_current_time(void) {
 	uint32_t returnValue;
 
-	/* Disable interrupts so we can be sure that the interrupt
-	 * doesn't fire when we've copied just a couple of bytes
-	 * of the value. Interrupts are re-enabled if they were
-	 * enabled at the start.
+	/* The interrupt may fire when we've copied just a couple of
+	 * bytes of the value. Rather than disabling interrupts we
+	 * read the value twice - if both reads agree then the
+	 * interrupt didn't change the value part way through. (The
+	 * tick only changes once a millisecond so we'll very rarely
+	 * need to go around more than once.)
 	 */
+	do {
+		returnValue = clockTicks;
+	} while(returnValue != clockTicks);
+	return returnValue;
+}
 
-	
+uint16_t get_current_time16(void) {
+	uint16_t returnValue;
+
+	/* Same approach as above - but only two bytes to copy */
+	do {
+		returnValue = (uint16_t)clockTicks;
+	} while(returnValue != (uint16_t)clockTicks);
+	return returnValue;
+}
 
+uint32_t get_current_time_us(void) {
+	uint32_t ticks;
+	uint8_t count;
 	uint8_t interruptsOn = bit_is_set(SREG, SREG_I);
+
+	/* The tick count and the timer count must be read together, so 
+	 * interrupts are turned off. If the timer has reached its compare
+	 * value but the interrupt hasn't been handled yet (the flag is still
+	 * set) then the tick count is one behind. (The count only goes back
+	 * to 0 after the match, so a high count was read before it.)
+	 */
 	cli();
-	returnValue = clockTicks;
+	ticks = clockTicks;
+	count = TCNT0;
+	if((TIFR0 & (1<<OCF0A)) && count < OCR0A / 2) {
+		ticks++;
+	}
 	if(interruptsOn) {
 		sei();
 	}
-	return returnValue;
+	/* Each timer count is 64 clock cycles - 8us */
+	return ticks * 1000 + count * 8;
 }
+
 ISR(TIMER0_COMPA_vect) {
+	/* Record how late we are - this must come first */
+	isrstats_timer0_entry();
+	ISR_STATS_BEGIN();
+
 	/* Increment our clock tick count */
 	clockTicks++;
 	 //SET OUR VARIABLES HERE
@@ -148,6 +184,7 @@ ISR(TIMER0_COMPA_vect) {
 	
 	//slow = slow +10;
 	//PORTC |= (1<<1)|(1<<2)|(1<<3)|(1<<4);
+	ISR_STATS_END(CS_ISR_TIMER0);
 
 }
 void lifeLost(int led){
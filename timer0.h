@@ -34,5 +34,22 @@ void init_timer0(void);
  * initialised.
  */
 uint32_t get_current_time(void);
+
+/* Return the low 16 bits of the current clock tick value. This is cheaper
+ * than get_current_time() and is suitable for measuring intervals of less
+ * than about 65 seconds, e.g. 
+ *     if((uint16_t)(get_current_time16() - start) >= 500) ...
+ * (The subtraction must be done in 16 bits so it handles wraparound.)
+ * Neither function disables interrupts.
+ */
+uint16_t get_current_time16(void);
+
+/* Return the time in microseconds (to the nearest 8us - one count of
+ * the timer) since the timer was initialised, for timing things that take
+ * less than a tick. Wraps around every ~71 minutes, so only differences
+ * should be used. Unlike the functions above this briefly disables 
+ * interrupts.
+ */
+uint32_t get_current_time_us(void);
 void resetX(int newx);
 #endif
\ No newline at end of file